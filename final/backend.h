@@ -0,0 +1,47 @@
+#ifndef _BACKEND_H
+#define _BACKEND_H
+
+#include "vga_ball.h"
+#include "input.h"
+
+/*
+ * Where frames go and where input comes from.  The loop in hello.c
+ * reaches the display and the pad only through one of these, so the
+ * game runs the same against the board or against files.
+ */
+typedef struct {
+    const char *name;
+
+    /* Nonzero to hold the loop to FRAME_HZ, zero to run flat out */
+    int paced;
+
+    /* Descriptor that delivers vblanks (see frame_timer_use_vblank()),
+       or -1 */
+    int vblank_fd;
+
+    /* Buffer the next frame is packed into */
+    frame_words *frame;
+
+    /* Pop the next pad report due by simulation tick frame.  Never
+       blocks.  Returns 1 if a report was stored, 0 if none is due yet
+       and -1 once the input has ended for good. */
+    int (*poll)(controller_packet *, unsigned long frame);
+
+    /* Show what was packed into frame */
+    void (*commit)(void);
+
+    /* Print end-of-run statistics and release everything */
+    void (*close)(void);
+} backend;
+
+/* /dev/vga_ball and the USB pad.  Returns NULL if either is missing. */
+extern backend *device_backend_open(void);
+
+/* No hardware.  Input is read from a text script (see
+   backend_headless.c), or there is none if input_path is NULL; frames
+   are thrown away, or appended to record_path when it is not NULL.
+   Returns NULL if a file cannot be opened. */
+extern backend *headless_backend_open(const char *input_path,
+                                      const char *record_path);
+
+#endif
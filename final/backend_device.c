@@ -0,0 +1,132 @@
+/*
+ * The board: frames go to /dev/vga_ball, input comes from the USB pad
+ * through the controller thread.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include "backend.h"
+#include "controller.h"
+
+static const char filename[] = "/dev/vga_ball";
+
+static int vga_ball_fd;
+
+/* Packed object words for the current frame.  Points at the driver's
+   shadow page when it can be mmap()ed, at frame_buf otherwise. */
+static frame_words frame_buf;
+static int frame_mapped = 0;
+
+static backend device;
+
+/**
+ * Pack straight into the driver's shadow table if we can map it
+ */
+static void map_frame() {
+
+    void *shadow = mmap(NULL, sizeof(frame_words), PROT_READ | PROT_WRITE,
+                        MAP_SHARED, vga_ball_fd, 0);
+
+    if (shadow != MAP_FAILED) {
+        device.frame = shadow;
+        frame_mapped = 1;
+    }
+}
+
+static void unmap_frame() {
+
+    if (frame_mapped) munmap(device.frame, sizeof(frame_words));
+
+    device.frame = &frame_buf;
+    frame_mapped = 0;
+}
+
+static int device_poll(controller_packet *packet, unsigned long frame) {
+
+    controller_event event;
+
+    if (!controller_poll(&event)) return 0;
+
+    *packet = event.packet;
+    return 1;
+}
+
+/**
+ * Send the packed frame to the device in one ioctl
+ */
+static void device_commit() {
+
+    if (frame_mapped) {
+        if (ioctl(vga_ball_fd, COMMIT_FRAME, 0)) {
+            perror("ioctl(COMMIT_FRAME) failed");
+            exit(EXIT_FAILURE);
+        }
+    }
+    else if (ioctl(vga_ball_fd, UPDATE_FRAME, device.frame)) {
+        perror("ioctl(UPDATE_FRAME) failed");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void device_close() {
+
+    vga_ball_stats stats;
+
+    if (ioctl(vga_ball_fd, READ_STATS, &stats) == 0 && stats.frames)
+        printf("%u frames committed: %llu object writes, %llu skipped (%llu/frame written)\n",
+                stats.frames, stats.writes, stats.skipped, stats.writes / stats.frames);
+
+    controller_stop();
+    unmap_frame();
+    close(vga_ball_fd);
+}
+
+backend *device_backend_open() {
+
+    struct libusb_device_handle *controller;
+    uint8_t endpoint_address;
+
+    /* Open the device file */
+    if ((vga_ball_fd = open(filename, O_RDWR)) == -1) {
+        fprintf(stderr, "Could not open %s\n", filename);
+        return NULL;
+    }
+
+    device = (backend) {
+        .name = "device",
+        .paced = 1,
+        .vblank_fd = vga_ball_fd,
+        .frame = &frame_buf,
+        .poll = device_poll,
+        .commit = device_commit,
+        .close = device_close,
+    };
+
+    map_frame();
+
+    /* Open the controller */
+    if ( (controller = opencontroller(&endpoint_address)) == NULL ) {
+        fprintf(stderr, "Did not find a controller\n");
+        goto fail_frame;
+    }
+
+    if (controller_start(controller, endpoint_address)) {
+        fprintf(stderr, "Could not start the controller\n");
+        goto fail_controller;
+    }
+
+    return &device;
+
+    /* Undo the steps above in reverse, as device_close() does */
+fail_controller:
+    libusb_release_interface(controller, 0);
+    libusb_close(controller);
+fail_frame:
+    unmap_frame();
+    close(vga_ball_fd);
+    return NULL;
+}
@@ -0,0 +1,117 @@
+/*
+ * No hardware.  Input comes from a text script with one pad report per
+ * line:
+ *
+ *     <frame> <lr_arrows> <ud_arrows> <buttons> <bumpers>
+ *
+ * frame is the simulation tick the report arrives on and the rest are
+ * the hex bytes the pad sends (see input.h).  Like the pad, a report
+ * holds until the next one, and the input ends after the last one.
+ * Blank lines and lines starting with # are skipped.
+ *
+ * Frames are thrown away, or appended to a file as raw frame_words so
+ * two runs can be compared byte for byte.
+ */
+
+#include <stdio.h>
+#include "backend.h"
+
+static FILE *input, *record;
+static const char *record_name;
+
+static frame_words frame_buf;
+static unsigned long commits;
+
+/* The next report in the script and the tick it is due on */
+static controller_packet next;
+static unsigned long next_frame;
+static int have_next;
+
+static backend headless;
+
+/* Read the next report into next.  Returns 0 at the end of the script. */
+static int read_report() {
+
+    char line[128];
+    unsigned int lr, ud, buttons, bumpers;
+
+    while (fgets(line, sizeof(line), input)) {
+
+        if (line[0] == '#' || line[0] == '\n') continue;
+
+        if (sscanf(line, "%lu %x %x %x %x", &next_frame, &lr, &ud, &buttons, &bumpers) != 5) {
+            fprintf(stderr, "skipping bad input line: %s", line);
+            continue;
+        }
+
+        next = (controller_packet) {
+            .lr_arrows = lr, .ud_arrows = ud,
+            .buttons = buttons, .bumpers = bumpers,
+        };
+        return 1;
+    }
+
+    return 0;
+}
+
+static int headless_poll(controller_packet *packet, unsigned long frame) {
+
+    if (!have_next) return -1;
+
+    if (next_frame > frame) return 0;
+
+    *packet = next;
+    have_next = read_report();
+
+    return 1;
+}
+
+static void headless_commit() {
+
+    commits++;
+
+    if (record && fwrite(&frame_buf, sizeof(frame_buf), 1, record) != 1) {
+        perror("recording frame failed");
+        fclose(record);
+        record = NULL;
+    }
+}
+
+static void headless_close() {
+
+    printf("%lu frames committed", commits);
+    if (record) printf(", recorded to %s", record_name);
+    printf("\n");
+
+    if (record) fclose(record);
+    if (input) fclose(input);
+}
+
+backend *headless_backend_open(const char *input_path, const char *record_path) {
+
+    if (input_path && (input = fopen(input_path, "r")) == NULL) {
+        perror(input_path);
+        return NULL;
+    }
+
+    if (record_path && (record = fopen(record_path, "wb")) == NULL) {
+        perror(record_path);
+        if (input) fclose(input);
+        return NULL;
+    }
+
+    record_name = record_path;
+    have_next = input && read_report();
+
+    headless = (backend) {
+        .name = "headless",
+        .paced = 0,
+        .vblank_fd = -1,
+        .frame = &frame_buf,
+        .poll = headless_poll,
+        .commit = headless_commit,
+        .close = headless_close,
+    };
+
+    return &headless;
+}
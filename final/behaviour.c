@@ -0,0 +1,232 @@
+/*
+ * Enemy dive scripts.  See behaviour.h for how a state is read.
+ */
+
+#include <stdlib.h>
+#include "behaviour.h"
+#include "fixed.h"
+
+/* The dive paths, from the wave file */
+static const wave_file *waves;
+
+enum {
+    /* ENEMY1: loop out, home in on the ship, give up and drop */
+    E1_TURN, E1_HOME, E1_FALL,
+
+    /* ENEMY2: loop out, wait for the ship to line up, swerve out and
+       back across it, then home in */
+    E2_TURN, E2_WAIT, E2_SWERVE_OUT, E2_SWERVE_BACK, E2_HOME,
+
+    /* ENEMY3: loop out at the ship, maybe double back, then drop,
+       chasing the ship sideways once past it */
+    E3_TURN, E3_DRIFT, E3_DRIFT_BACK, E3_FALL,
+
+    BEHAVIOUR_STATES
+};
+
+#define TURN(then) { \
+    .move = { .rule = MOVE_TURN, .side = SIDE_OUT_TURN }, \
+    .duration = DURATION_PATH, .next = (then) }
+
+#define SET(x, y, s) { .rule = MOVE_SET, .vx = (x), .vy = (y), .side = (s) }
+#define SET_X(x, s) { .rule = MOVE_SET_X, .vx = (x), .side = (s) }
+#define AIM(v) { .rule = MOVE_AIM, .speed = (v) }
+
+/* Bail-outs when the ship is gone or about to be passed */
+#define E1_GUARD .guard = COND_SHIP_GONE, .guarded = SET(0, 4, SIDE_NONE)
+#define E2_GUARD .guard = COND_SHIP_CLOSE, .guarded = SET(1, 4, SIDE_AWAY)
+#define E3_GUARD .guard = COND_SHIP_GONE, .guarded = SET(1, 4, SIDE_AWAY)
+
+/* Sideways at the ship once below it */
+#define E3_CHASE { .rule = MOVE_SET, .vx = 1, .vy = 2, .side = SIDE_AWAY, .when = COND_SHIP_PASSED }
+
+const behaviour_state behaviour_states[BEHAVIOUR_STATES] = {
+
+    [E1_TURN] = TURN(E1_HOME),
+    [E1_HOME] = { E1_GUARD, .enter = SET(2, 1, SIDE_CENTER), .move = AIM(3),
+                  .duration = 250, .next = E1_FALL, .armed = 1 },
+    [E1_FALL] = { E1_GUARD, .move = SET(0, 2, SIDE_NONE), .armed = 1 },
+
+    [E2_TURN] = TURN(E2_WAIT),
+    [E2_WAIT] = { E2_GUARD, .enter = SET(4, 2, SIDE_CENTER),
+                  .duration = 1, .until = COND_LINED_UP, .next = E2_SWERVE_OUT, .armed = 1 },
+    [E2_SWERVE_OUT] = { E2_GUARD, .enter = AIM(2), .move = SET_X(2, SIDE_OUT),
+                        .duration = 75, .next = E2_SWERVE_BACK, .armed = 1 },
+    [E2_SWERVE_BACK] = { E2_GUARD, .move = SET_X(-2, SIDE_OUT),
+                         .duration = 75, .next = E2_HOME, .armed = 1 },
+    [E2_HOME] = { E2_GUARD, .move = AIM(2), .armed = 1 },
+
+    [E3_TURN] = TURN(E3_DRIFT),
+    [E3_DRIFT] = { E3_GUARD, .enter = AIM(3), .move = E3_CHASE,
+                   .duration = 150, .until = COND_ONE_IN_FOUR, .next = E3_DRIFT_BACK, .armed = 1 },
+    [E3_DRIFT_BACK] = { E3_GUARD, .enter = { .rule = MOVE_REVERSE }, .move = E3_CHASE,
+                        .duration = 100, .next = E3_FALL, .armed = 1 },
+    [E3_FALL] = { E3_GUARD, .enter = SET(0, 2, SIDE_NONE), .move = E3_CHASE, .armed = 1 },
+};
+
+void behaviour_load(const wave_file *w){
+
+    waves = w;
+}
+
+int behaviour_start(char sprite){
+
+    switch (sprite){
+        case ENEMY1: return E1_TURN;
+        case ENEMY2: return E2_TURN;
+        default: return E3_TURN;
+    }
+}
+
+/* Where the ship is, which behaviour reads like any other entity */
+#define SHIP_X(w) ((w)->body.pos_x[ecs_body(w, ECS_SHIP)])
+#define SHIP_Y(w) ((w)->body.pos_y[ecs_body(w, ECS_SHIP)])
+
+static bool holds(const ecs_world *w, const enemy_store *e, int cond, int i){
+
+    int d = ecs_body(w, i);
+
+    switch (cond){
+
+        case COND_SHIP_GONE:
+            return !ecs_has(w, ECS_SHIP, C_ACTIVE, 0);
+
+        case COND_SHIP_CLOSE:
+            return !ecs_has(w, ECS_SHIP, C_ACTIVE, 0) || w->body.pos_y[d] + 30 >= SHIP_Y(w);
+
+        case COND_SHIP_PASSED:
+            return w->body.pos_y[d] > SHIP_Y(w);
+
+        case COND_LINED_UP:
+            return SHIP_Y(w) - w->body.pos_y[d] < 150 &&
+                (SHIP_X(w) - w->body.pos_x[d] > 10 ||
+                 (e->start_x[i] < SCREEN_WIDTH/2 && w->body.pos_x[d] - SHIP_X(w) > 10));
+
+        case COND_ONE_IN_FOUR:
+            return rand() % 4 == 0;
+    }
+
+    return true;
+}
+
+static int side_of(const ecs_world *w, const enemy_store *e, int side, int i){
+
+    int d = ecs_body(w, i);
+
+    switch (side){
+        case SIDE_CENTER: return w->body.pos_x[d] < SCREEN_WIDTH/2 ? 1 : -1;
+        case SIDE_AWAY: return w->body.pos_x[d] > SHIP_X(w) ? 1 : -1;
+        case SIDE_OUT: return e->start_x[i] < SCREEN_WIDTH/2 ? -1 : 1;
+        case SIDE_OUT_TURN: return e->start_x[i] <= SCREEN_WIDTH/2 ? -1 : 1;
+    }
+
+    return 1;
+}
+
+static void apply(ecs_world *w, const enemy_store *e, const behaviour_move *m, int i){
+
+    body_data *body = &w->body;
+    int d = ecs_body(w, i);
+    short vx, vy;
+
+    if (m->when != COND_NONE && !holds(w, e, m->when, i)) return;
+
+    switch (m->rule){
+
+        case MOVE_SET:
+            body->velo_x[d] = FIX(side_of(w, e, m->side, i) * m->vx);
+            body->velo_y[d] = FIX(m->vy);
+            break;
+
+        case MOVE_SET_X:
+            body->velo_x[d] = FIX(side_of(w, e, m->side, i) * m->vx);
+            break;
+
+        case MOVE_AIM:
+            fix_aim(SHIP_X(w) - body->pos_x[d], SHIP_Y(w) - body->pos_y[d], m->speed,
+                    &body->velo_x[d], &body->velo_y[d]);
+            break;
+
+        case MOVE_TURN:
+            wave_path_velocity(waves, e->path[i], w->dive.move_time[ecs_dive(w, i)] - 1, &vx, &vy);
+            body->velo_x[d] = side_of(w, e, m->side, i) * vx;
+            body->velo_y[d] = vy;
+            break;
+
+        case MOVE_REVERSE:
+            body->velo_x[d] = -body->velo_x[d];
+            break;
+    }
+}
+
+/* One tick of every enemy in state s */
+static void run_batch(ecs_world *w, const enemy_store *e, int s,
+                      const short *batch, int n, int parity){
+
+    const behaviour_state *st = &behaviour_states[s];
+    const behaviour_state *next = &behaviour_states[st->next];
+    const behaviour_move *enter = next->enter.rule != MOVE_KEEP ? &next->enter : &next->move;
+    dive_data *dive = &w->dive;
+
+    for (int k = 0; k < n; k++){
+
+        int i = batch[k], j = ecs_dive(w, i), duration;
+
+        if (st->guard != COND_NONE && holds(w, e, st->guard, i)){
+
+            apply(w, e, &st->guarded, i);
+            continue;
+        }
+
+        duration = st->duration == DURATION_PATH ?
+            waves->paths[e->path[i]].length : st->duration;
+
+        if (duration && ++dive->move_time[j] >= duration){
+
+            /* Time is up but the way out is shut: try again next tick */
+            if (st->until != COND_NONE && !holds(w, e, st->until, i)){
+
+                dive->move_time[j]--;
+                continue;
+            }
+
+            dive->state[j] = st->next;
+            dive->move_time[j] = 0;
+
+            apply(w, e, enter, i);
+            continue;
+        }
+
+        /* Homing is the costly rule; hold the heading a tick when told */
+        if (st->move.rule == MOVE_AIM && (i & 1) == parity) continue;
+
+        apply(w, e, &st->move, i);
+    }
+}
+
+void behaviour_update(ecs_world *w, const enemy_store *e, int parity){
+
+    const ecs_set *divers = ecs_members(w, C_DIVING);
+    const unsigned char *state = w->dive.state;
+    short batch[ENEMY_COUNT];
+    int start[BEHAVIOUR_STATES + 1] = { 0 }, fill[BEHAVIOUR_STATES];
+
+    /* Counting sort of the divers by state, in set order within.  The
+       state is packed the same way as the set, so this reads it front
+       to back.  Returning enemies only head home, so leave them out. */
+    for (int n = 0; n < divers->count; n++)
+        if (ecs_has(w, divers->dense[n], 0, C_RETURNING)) start[state[n] + 1]++;
+
+    for (int s = 0; s < BEHAVIOUR_STATES; s++){
+
+        start[s + 1] += start[s];
+        fill[s] = start[s];
+    }
+
+    for (int n = 0; n < divers->count; n++)
+        if (ecs_has(w, divers->dense[n], 0, C_RETURNING)) batch[fill[state[n]]++] = divers->dense[n];
+
+    for (int s = 0; s < BEHAVIOUR_STATES; s++)
+        if (start[s + 1] > start[s])
+            run_batch(w, e, s, batch + start[s], start[s + 1] - start[s], parity);
+}
@@ -0,0 +1,88 @@
+#ifndef _BEHAVIOUR_H
+#define _BEHAVIOUR_H
+
+#include <stdbool.h>
+#include "entities.h"
+#include "ecs.h"
+#include "wave.h"
+
+/*
+ * Diving enemies as table-driven state machines.
+ *
+ * Each enemy type is a short script of states in behaviour_states[].
+ * A state says how the enemy steers while in it, what it does on the
+ * tick it enters, how long it lasts (counted in the enemy's move_time)
+ * and which state comes next.  Both live in the C_DIVING component's
+ * data (ecs_world.dive).  A guard can override the state while
+ * it holds, e.g. when the ship is gone, without running its clock.
+ *
+ * behaviour_update() sorts the C_DIVING set by state and runs each state's
+ * enemies as one batch, so the rule being applied is the same for a
+ * whole run of enemies and its branches predict.  A new enemy type is
+ * new rows in the table, not new code in the loop.
+ */
+
+/* How a move sets the velocity */
+enum {
+    MOVE_KEEP,              /* leave it */
+    MOVE_SET,               /* vx, vy */
+    MOVE_SET_X,             /* vx, leave velo_y */
+    MOVE_AIM,               /* at the ship at speed */
+    MOVE_TURN,              /* fly the enemy's dive path, at tick move_time */
+    MOVE_REVERSE,           /* flip velo_x */
+};
+
+/* Conditions on the enemy and the ship.  COND_NONE is "never" as a
+   guard and "always" everywhere else. */
+enum {
+    COND_NONE,
+    COND_SHIP_GONE,         /* the ship is not active */
+    COND_SHIP_CLOSE,        /* ... or less than 30 pixels below */
+    COND_SHIP_PASSED,       /* the enemy is below the ship */
+    COND_LINED_UP,          /* the ship is in reach of a swerve */
+    COND_ONE_IN_FOUR,       /* a 1 in 4 roll of rand() */
+};
+
+/* Sign of a move's vx */
+enum {
+    SIDE_NONE,              /* as written */
+    SIDE_CENTER,            /* towards the middle of the screen */
+    SIDE_AWAY,              /* away from the ship */
+    SIDE_OUT,               /* away from the middle, by where it started */
+    SIDE_OUT_TURN,          /* the same, with the middle column going left */
+};
+
+typedef struct {
+    unsigned char rule, when, side;
+    signed char vx, vy, speed;      /* whole pixels per tick */
+} behaviour_move;
+
+typedef struct {
+    unsigned char guard;        /* overrides the state while it holds */
+    behaviour_move guarded;     /* velocity meanwhile; the clock stops */
+    behaviour_move enter;       /* on the tick the state is entered, or move if KEEP */
+    behaviour_move move;        /* on every other tick */
+    short duration;             /* ticks in the state, 0 for no end,
+                                   DURATION_PATH for its dive path's */
+    unsigned char until;        /* and what must hold to leave it then */
+    unsigned char next;
+    bool armed;                 /* may shoot */
+} behaviour_state;
+
+#define DURATION_PATH (-1)
+
+extern const behaviour_state behaviour_states[];
+
+/* Take the dive paths from w, which must stay mapped */
+extern void behaviour_load(const wave_file *w);
+
+/* First state of an enemy's script when it leaves the formation */
+extern int behaviour_start(char sprite);
+
+/* Run one tick of every diver not already returning, steering at the
+   ECS_SHIP entity.  With parity 0 or 1 the enemies whose number has
+   that parity keep their heading instead of re-aiming this tick; -1
+   re-aims them all. */
+extern void behaviour_update(ecs_world *, const enemy_store *, int parity);
+
+#endif
@@ -0,0 +1,318 @@
+/*
+ * Microbenchmarks for the per-tick hot paths, run against synthetic
+ * worlds.  The entity count is fixed when the game is compiled, so
+ * make bench builds one binary per size (bench_60, bench_600,
+ * bench_6000) with ENEMY_COUNT set to that size and a quarter as many
+ * enemy bullets.
+ *
+ * Each benchmark prints one JSON object per line:
+ *
+ *     {"bench":"enemy_movement","entities":600,"ops":...,
+ *      "ns_per_op":...,"allocs_per_op":...}
+ *
+ * Allocations are counted by wrapping malloc, calloc and realloc at
+ * link time, so anything the game allocates on these paths shows up.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "game.h"
+#include "frame.h"
+#include "fixed.h"
+#include "behaviour.h"
+#include "pattern.h"
+#include "ecs.h"
+
+/* Run each benchmark for at least this long */
+#define BENCH_NS 200000000L
+
+#define ENEMY_SPRITES 3
+
+static unsigned long allocs;
+
+void *__real_malloc(size_t);
+void *__real_calloc(size_t, size_t);
+void *__real_realloc(void *, size_t);
+
+void *__wrap_malloc(size_t n) { allocs++; return __real_malloc(n); }
+void *__wrap_calloc(size_t n, size_t m) { allocs++; return __real_calloc(n, m); }
+void *__wrap_realloc(void *p, size_t n) { allocs++; return __real_realloc(p, n); }
+
+static game_world world;    /* synthetic state every run starts from */
+static wave_file waves;
+static frame_words frame;
+
+static long now_ns(void) {
+
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return t.tv_sec * 1000000000L + t.tv_nsec;
+}
+
+/*
+ * A mid-round world: every enemy alive, a quarter of them diving at
+ * various points of their attack, half the enemy bullets and all the
+ * ship bullets in flight.
+ */
+static void make_world(void) {
+
+    static const char sprites[ENEMY_SPRITES] = { ENEMY1, ENEMY2, ENEMY3 };
+    ecs_world *w = &world.ecs;
+    body_data *body = &w->body;
+    enemy_store *e = &world.enemies;
+    bullet_store *b = &world.bullets;
+    int k, d;
+
+    srand(4840);
+    memset(&world, 0, sizeof(world));
+
+    world.ship = (ship_state) { .lives = LIFE_COUNT, .num_buls = SHIP_BULLETS };
+
+    ecs_add(w, ECS_SHIP, C_BODY | C_ACTIVE);
+    body->pos_x[ecs_body(w, ECS_SHIP)] = SCREEN_WIDTH / 2;
+    body->pos_y[ecs_body(w, ECS_SHIP)] = SCREEN_HEIGHT - 80;
+    body->sprite[ecs_body(w, ECS_SHIP)] = SHIP;
+    ecs_add(w, ECS_POWERUP, C_BODY);
+
+    pool_init(&b->slots, MAX_BULLETS);
+    wheel_init(&world.timers, GAME_TIMERS);
+    pattern_init(&world.emitters);
+
+    for (int i = 0; i < ENEMY_COUNT; i++) {
+
+        ecs_add(w, i, C_BODY | C_ACTIVE);
+        d = ecs_body(w, i);
+
+        body->pos_x[d] = e->start_x[i] = rand() % SCREEN_WIDTH;
+        body->pos_y[d] = e->start_y[i] = rand() % (SCREEN_HEIGHT / 2);
+        body->sprite[d] = sprites[i % ENEMY_SPRITES];
+        e->row[i] = i % 5;
+        e->col[i] = i % MAX_COLUMNS;
+        e->bul[i] = e->emitter[i] = POOL_NONE;
+        e->path[i] = i % waves.header->paths;
+
+        if (i % 4 == 0) {
+            ecs_add(w, i, C_DIVING);
+            /* Somewhere in the first three states of its script */
+            w->dive.state[ecs_dive(w, i)] = behaviour_start(body->sprite[d]) + rand() % 3;
+            w->dive.move_time[ecs_dive(w, i)] = rand() % 70;
+            body->velo_x[d] = FIX(rand() % 5 - 2);
+            body->velo_y[d] = FIX(rand() % 4 + 1);
+        }
+
+        else
+            ecs_add(w, i, C_FORMATION);
+    }
+
+    for (int n = 0; n < MAX_BULLETS / 2; n++) {
+
+        k = pool_acquire(&b->slots);
+
+        b->active[k] = 1;
+        b->pos_x[k] = rand() % SCREEN_WIDTH;
+        b->pos_y[k] = rand() % SCREEN_HEIGHT;
+        b->velo_x[k] = rand() % (2 * FIX_ONE) - FIX_ONE;
+        b->velo_y[k] = FIX(3);
+    }
+
+    for (int n = 0; n < SHIP_BULLETS; n++) {
+
+        ecs_add(w, ECS_SHIP_BULLET + n, C_BODY | C_ACTIVE | C_SHOT);
+        d = ecs_body(w, ECS_SHIP_BULLET + n);
+
+        body->pos_x[d] = rand() % SCREEN_WIDTH;
+        body->pos_y[d] = rand() % SCREEN_HEIGHT;
+        body->velo_y[d] = FIX(-3);
+        body->sprite[d] = SHIP_BULLET;
+    }
+}
+
+/* Put the synthetic world back */
+static void reset(void) {
+
+    *game_world_state() = world;
+}
+
+static void report(const char *name, long ns, unsigned long ops, unsigned long allocated) {
+
+    printf("{\"bench\":\"%s\",\"entities\":%d,\"ops\":%lu,"
+           "\"ns_per_op\":%.1f,\"allocs_per_op\":%.3f}\n",
+           name, ENEMY_COUNT, ops, (double) ns / ops, (double) allocated / ops);
+}
+
+/*
+ * Time run() until BENCH_NS have been spent inside it.  setup() runs
+ * before every call, outside the clock, so each call sees the same
+ * starting state.  run() returns how many operations it did.
+ */
+static void bench(const char *name, void (*setup)(void), unsigned long (*run)(void)) {
+
+    long spent = 0, start;
+    unsigned long ops = 0, allocated = 0, before;
+
+    while (spent < BENCH_NS) {
+
+        if (setup) setup();
+
+        before = allocs;
+        start = now_ns();
+
+        ops += run();
+
+        spent += now_ns() - start;
+        allocated += allocs - before;
+    }
+
+    report(name, spent, ops, allocated);
+}
+
+
+/* fix_aim() (was calculate_velo()) over one offset per entity */
+
+static short aim_dx[ENEMY_COUNT], aim_dy[ENEMY_COUNT];
+static short aim_vx[ENEMY_COUNT], aim_vy[ENEMY_COUNT];
+
+static unsigned long run_fix_aim(void) {
+
+    for (int i = 0; i < ENEMY_COUNT; i++)
+        fix_aim(aim_dx[i], aim_dy[i], 3, &aim_vx[i], &aim_vy[i]);
+
+    return ENEMY_COUNT;
+}
+
+/* Every enemy's dive path velocity at some tick of it */
+
+static short path_tick[ENEMY_COUNT];
+
+static unsigned long run_path_velocity(void) {
+
+    enemy_store *e = &world.enemies;
+
+    for (int i = 0; i < ENEMY_COUNT; i++)
+        wave_path_velocity(&waves, e->path[i], path_tick[i], &aim_vx[i], &aim_vy[i]);
+
+    return ENEMY_COUNT;
+}
+
+static void setup_grid(void) {
+
+    reset();
+    build_enemy_grid();
+}
+
+static unsigned long run_bullet_colision(void) {
+
+    for (int k = 0; k < SHIP_BULLETS; k++)
+        bullet_colision(k);
+
+    return SHIP_BULLETS;
+}
+
+static unsigned long run_enemy_movement(void) {
+
+    enemy_movement(-1);
+
+    return 1;
+}
+
+static unsigned long run_move_enemy_bul(void) {
+
+    move_enemy_bul();
+
+    return 1;
+}
+
+static unsigned long run_init_round_state(void) {
+
+    init_round_state();
+
+    return 1;
+}
+
+/* Packing only reads the world, so load it once */
+static void reset_once(void) {
+
+    static int done;
+
+    if (!done++) reset();
+}
+
+static unsigned long run_pack_frame(void) {
+
+    pack_frame(game_world_state(), &frame);
+
+    return 1;
+}
+
+/* Radial bursts into an empty bullet pool, enough rings to fill it;
+   one op per bullet fired */
+static void setup_volley(void) {
+
+    game_world *w = game_world_state();
+
+    reset();
+    pool_init(&w->bullets.slots, MAX_BULLETS);
+    memset(w->bullets.active, 0, sizeof(w->bullets.active));
+
+    for (int n = 0; n == 0 || n < MAX_BULLETS / 16; n++)
+        pattern_start(w, PATTERN_RADIAL, -1, rand() % SCREEN_WIDTH, rand() % (SCREEN_HEIGHT / 2));
+}
+
+static unsigned long run_pattern_volley(void) {
+
+    pattern_update(game_world_state());
+
+    return game_world_state()->bullets.slots.count;
+}
+
+/* A second of play with a spiral from every tenth enemy on top of the
+   bullets already in flight, so the pool stays near full */
+#define PATTERN_TICKS 60
+
+static void setup_spirals(void) {
+
+    reset();
+
+    for (int i = 0; i < ENEMY_COUNT; i += 10)
+        pattern_start(game_world_state(), PATTERN_SPIRAL, i, 0, 16);
+}
+
+static unsigned long run_pattern_tick(void) {
+
+    for (int t = 0; t < PATTERN_TICKS; t++)
+        move_enemy_bul();
+
+    return PATTERN_TICKS;
+}
+
+
+int main() {
+
+    if (wave_open(&waves, "waves.bin")) return 1;
+
+    /* For the tables the game keeps outside the world */
+    game_init(&waves);
+    make_world();
+
+    for (int i = 0; i < ENEMY_COUNT; i++) {
+        aim_dx[i] = rand() % (2 * SCREEN_WIDTH) - SCREEN_WIDTH;
+        aim_dy[i] = rand() % (2 * SCREEN_HEIGHT) - SCREEN_HEIGHT;
+        path_tick[i] = rand() % waves.paths[world.enemies.path[i]].length;
+    }
+
+    bench("fix_aim", NULL, run_fix_aim);
+    bench("path_velocity", NULL, run_path_velocity);
+    bench("bullet_colision", setup_grid, run_bullet_colision);
+    bench("enemy_movement", reset, run_enemy_movement);
+    bench("move_enemy_bul", reset, run_move_enemy_bul);
+    bench("init_round_state", reset, run_init_round_state);
+    bench("pack_frame", reset_once, run_pack_frame);
+    bench("pattern_volley", setup_volley, run_pattern_volley);
+    bench("pattern_tick", setup_spirals, run_pattern_tick);
+
+    return 0;
+}
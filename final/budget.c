@@ -0,0 +1,35 @@
+#include "budget.h"
+
+void budget_init(frame_budget *b, long budget_ns) {
+
+    b->budget = budget_ns;
+    b->cost = 0;
+    b->level = 0;
+    b->calm = 0;
+    b->frames = b->over = b->degraded = 0;
+}
+
+int budget_account(frame_budget *b, long spent_ns) {
+
+    b->frames++;
+    if (b->level) b->degraded++;
+
+    b->cost += (spent_ns - b->cost) >> BUDGET_SMOOTHING;
+
+    /* One bad frame is enough to back off: the next one would miss too */
+    if (spent_ns > b->budget || b->cost > b->budget * 3 / 4) {
+
+        if (spent_ns > b->budget) b->over++;
+        if (b->level < BUDGET_LEVELS - 1) b->level++;
+
+        b->calm = 0;
+    }
+
+    else if (b->level && b->cost < b->budget / 2 && ++b->calm >= BUDGET_RECOVER) {
+
+        b->level--;
+        b->calm = 0;
+    }
+
+    return b->level;
+}
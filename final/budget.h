@@ -0,0 +1,36 @@
+#ifndef _BUDGET_H
+#define _BUDGET_H
+
+/* Levels of detail the watchdog steps through, see game_set_detail() */
+#define BUDGET_LEVELS 3
+
+/* Smoothing of the cost estimate: each frame moves it 1/8 of the way */
+#define BUDGET_SMOOTHING 3
+
+/* Frames the cost has to stay under half the budget before detail
+   comes back one level */
+#define BUDGET_RECOVER 120
+
+/*
+ * Frame-budget watchdog.  Fed what the simulation cost each frame, it
+ * raises the level of detail to drop as soon as a frame runs over or
+ * the running cost nears the budget, and lowers it again only after a
+ * sustained stretch of headroom, so it does not flap at the edge.
+ */
+typedef struct {
+    long budget;            /* nanoseconds of simulation per frame */
+    long cost;              /* smoothed cost per frame */
+    int level;              /* 0 for everything, up to BUDGET_LEVELS-1 */
+    int calm;               /* frames in a row with room to spare */
+    unsigned long frames;   /* frames accounted */
+    unsigned long over;     /* frames that ran over budget */
+    unsigned long degraded; /* frames run below full detail */
+} frame_budget;
+
+extern void budget_init(frame_budget *, long budget_ns);
+
+/* Account one frame's simulation time.  Returns the level of detail
+   the next frame should run at. */
+extern int budget_account(frame_budget *, long spent_ns);
+
+#endif
@@ -0,0 +1,121 @@
+#include "commit.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "frame_timer.h"
+#include "trace.h"
+#include "perf.h"
+
+/* Set in the shared index when it holds a frame nobody has taken */
+#define FRESH 4
+
+static frame_words buffers[3];
+
+/* back is the simulation's, front the commit thread's, and the shared
+   one sits in middle; each side swaps its own for it */
+static unsigned int back = 0, front = 1;
+static atomic_uint middle = 2;
+
+static backend *out;
+static pthread_t commit_thread;
+static atomic_int running;
+
+static unsigned long shown;
+static atomic_ulong replaced;
+
+frame_words *commit_back() {
+
+    return &buffers[back];
+}
+
+void commit_publish() {
+
+    unsigned int prev = atomic_exchange_explicit(&middle, back | FRESH,
+                                                 memory_order_acq_rel);
+
+    if (prev & FRESH)
+        atomic_fetch_add_explicit(&replaced, 1, memory_order_relaxed);
+
+    back = prev & ~FRESH;
+}
+
+/* Take the newest frame if there is one we have not committed */
+static frame_words *take() {
+
+    unsigned int prev;
+
+    if (!(atomic_load_explicit(&middle, memory_order_acquire) & FRESH))
+        return NULL;
+
+    prev = atomic_exchange_explicit(&middle, front, memory_order_acq_rel);
+    front = prev & ~FRESH;
+
+    return &buffers[front];
+}
+
+static void commit_newest() {
+
+    frame_words *frame;
+
+    if ((frame = take()) == NULL) return;
+
+    TRACE_BEGIN(commit);
+    memcpy(out->frame, frame, sizeof(*frame));
+    out->commit();
+    TRACE_END(TRACE_COMMIT, commit);
+
+    shown++;
+}
+
+static void *commit_loop(void *arg) {
+
+    frame_timer timer;
+
+    frame_timer_start(&timer, FRAME_NS);
+
+    if (out->vblank_fd == -1 || frame_timer_use_vblank(&timer, out->vblank_fd))
+        fprintf(stderr, "commit thread: no vblank, committing at %d Hz\n", FRAME_HZ);
+
+    /* The commit ioctl runs here, so count it here if the game is counting */
+    if (perf_counting()) perf_open("commit");
+
+    while (atomic_load(&running)) {
+
+        /* Only the wakeup matters here; the count is the simulation's business */
+        frame_timer_steps(&timer);
+
+        commit_newest();
+        frame_timer_wait(&timer);
+    }
+
+    perf_close();
+
+    return NULL;
+}
+
+int commit_start(backend *io) {
+
+    out = io;
+    atomic_store(&running, 1);
+
+    if (pthread_create(&commit_thread, NULL, commit_loop, NULL)) {
+        atomic_store(&running, 0);
+        return -1;
+    }
+
+    return 0;
+}
+
+void commit_stop() {
+
+    atomic_store(&running, 0);
+    pthread_join(commit_thread, NULL);
+
+    /* Whatever the simulation published last still goes out */
+    commit_newest();
+
+    printf("%lu frames shown, %lu replaced before the display took them\n",
+           shown, atomic_load(&replaced));
+}
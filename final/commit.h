@@ -0,0 +1,33 @@
+#ifndef _COMMIT_H
+#define _COMMIT_H
+
+#include "backend.h"
+
+/*
+ * A second thread that owns the backend's commit.  The simulation
+ * packs each frame into commit_back() and publishes it; the commit
+ * thread wakes once per vblank (or per FRAME_HZ tick when the backend
+ * has none), takes the newest published frame and commits it.
+ *
+ * The three frame buffers are handed around with one atomic exchange
+ * per publish and per take, so neither side ever waits for the other:
+ * the simulation never sits in an ioctl, and the commit thread never
+ * sees a frame that is still being packed.
+ */
+
+/* Start the commit thread for io.  Returns 0 on success. */
+extern int commit_start(backend *io);
+
+/* Buffer to pack the next frame into.  Owned by the caller until
+   commit_publish(). */
+extern frame_words *commit_back(void);
+
+/* Make the frame packed into commit_back() the newest one.  Never
+   blocks; a frame the commit thread has not taken yet is replaced. */
+extern void commit_publish(void);
+
+/* Commit the newest frame, stop the thread and print how many frames
+   were shown and how many were replaced before they could be */
+extern void commit_stop(void);
+
+#endif
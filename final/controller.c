@@ -2,6 +2,9 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
 /* References on libusb 1.0 and the USB HID/keyboard protocol
  *
@@ -83,4 +86,148 @@ found:
   libusb_free_device_list(devs, 1);
 
   return controller;
-}
\ No newline at end of file
+}
+
+/*
+ * Asynchronous input
+ *
+ * One thread owns the USB side: it keeps a single interrupt transfer
+ * queued and runs the libusb event loop.  Each completed report is
+ * timestamped and pushed into a single-producer/single-consumer ring
+ * that the game loop drains once per frame without blocking.
+ */
+
+static controller_event ring[INPUT_RING_SIZE];
+static atomic_uint ring_head;   /* next slot to write, owned by the input thread */
+static atomic_uint ring_tail;   /* next slot to read, owned by the game loop */
+static atomic_uint dropped;
+
+static struct libusb_transfer *transfer;
+static controller_packet transfer_buf;
+static pthread_t input_thread;
+static atomic_int running;
+static atomic_int transfer_pending;
+
+static void ring_push(const controller_packet *packet) {
+
+  unsigned int head = atomic_load_explicit(&ring_head, memory_order_relaxed);
+  unsigned int tail = atomic_load_explicit(&ring_tail, memory_order_acquire);
+  controller_event *event;
+
+  if (head - tail == INPUT_RING_SIZE) {
+    atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+    return;
+  }
+
+  event = &ring[head & (INPUT_RING_SIZE - 1)];
+  event->packet = *packet;
+  clock_gettime(CLOCK_MONOTONIC, &event->time);
+
+  atomic_store_explicit(&ring_head, head + 1, memory_order_release);
+}
+
+int controller_poll(controller_event *event) {
+
+  unsigned int tail = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+  unsigned int head = atomic_load_explicit(&ring_head, memory_order_acquire);
+
+  if (head == tail) return 0;
+
+  *event = ring[tail & (INPUT_RING_SIZE - 1)];
+
+  atomic_store_explicit(&ring_tail, tail + 1, memory_order_release);
+  return 1;
+}
+
+unsigned int controller_dropped(void) {
+  return atomic_load_explicit(&dropped, memory_order_relaxed);
+}
+
+static void transfer_done(struct libusb_transfer *t) {
+
+  if (t->status == LIBUSB_TRANSFER_COMPLETED &&
+      t->actual_length == sizeof(controller_packet))
+    ring_push((controller_packet *) t->buffer);
+
+  /* Keep exactly one transfer in flight until we are told to stop */
+  if (atomic_load(&running) &&
+      t->status != LIBUSB_TRANSFER_NO_DEVICE &&
+      t->status != LIBUSB_TRANSFER_CANCELLED &&
+      libusb_submit_transfer(t) == 0)
+    return;
+
+  atomic_store(&transfer_pending, 0);
+}
+
+static void *input_loop(void *arg) {
+
+  struct timeval timeout = { 0, 100000 };
+
+  (void) arg;
+
+  /* Wake up every 100 ms so a stop request is noticed even if the pad
+     goes quiet */
+  while (atomic_load(&transfer_pending))
+    libusb_handle_events_timeout_completed(NULL, &timeout, NULL);
+
+  return NULL;
+}
+
+int controller_start(struct libusb_device_handle *controller,
+                     uint8_t endpoint_address) {
+
+  int r;
+
+  if ((transfer = libusb_alloc_transfer(0)) == NULL) {
+    fprintf(stderr, "Error: libusb_alloc_transfer failed\n");
+    return -1;
+  }
+
+  libusb_fill_interrupt_transfer(transfer, controller, endpoint_address,
+      (unsigned char *) &transfer_buf, sizeof(transfer_buf),
+      transfer_done, NULL, 0);
+
+  atomic_store(&running, 1);
+  atomic_store(&transfer_pending, 1);
+
+  if ((r = libusb_submit_transfer(transfer)) != 0) {
+    fprintf(stderr, "Error: libusb_submit_transfer failed: %s (%d)\n",
+        libusb_error_name(r), r);
+    goto fail;
+  }
+
+  if ((r = pthread_create(&input_thread, NULL, input_loop, NULL)) != 0) {
+    fprintf(stderr, "Error: pthread_create failed: %d\n", r);
+    libusb_cancel_transfer(transfer);
+    goto fail;
+  }
+
+  return 0;
+
+fail:
+  atomic_store(&running, 0);
+  atomic_store(&transfer_pending, 0);
+  libusb_free_transfer(transfer);
+  transfer = NULL;
+  return -1;
+}
+
+void controller_stop(void) {
+
+  if (transfer == NULL) return;
+
+  atomic_store(&running, 0);
+
+  /* A callback that read running before we cleared it resubmits
+     after our cancel, and with a quiet pad that transfer would never
+     finish; cancel again until the last one has come back */
+  while (atomic_load(&transfer_pending)) {
+    libusb_cancel_transfer(transfer);
+    usleep(1000);
+  }
+
+  pthread_join(input_thread, NULL);
+
+  libusb_free_transfer(transfer);
+  transfer = NULL;
+}
@@ -2,23 +2,36 @@
 #define _CONTROLLER_H
 
 #include <libusb-1.0/libusb.h>
+#include <time.h>
+#include "input.h"
 
+/* Slots in the input ring; must be a power of two */
+#define INPUT_RING_SIZE 64
 
+/* A report from the pad and the CLOCK_MONOTONIC time it arrived */
 typedef struct {
-    uint8_t pad_1;
-    uint8_t pad_2;
-    uint8_t pad_3;
-    uint8_t lr_arrows;
-    uint8_t ud_arrows;
-    uint8_t buttons;
-    uint8_t bumpers; // maybe change name
-    uint8_t pad_4;
-
-} controller_packet;
+    controller_packet packet;
+    struct timespec time;
+} controller_event;
 
 /* Find and open a USB keyboard device.  Argument should point to
    space to store an endpoint address.  Returns NULL if no keyboard
    device was found. */
 extern struct libusb_device_handle *opencontroller(uint8_t *);
 
+/* Start the input thread: it keeps an asynchronous interrupt transfer
+   in flight on the given endpoint and queues every report it gets.
+   Returns 0 on success. */
+extern int controller_start(struct libusb_device_handle *, uint8_t);
+
+/* Pop the oldest queued report.  Never blocks; returns 1 if an event
+   was stored, 0 if the ring was empty. */
+extern int controller_poll(controller_event *);
+
+/* Number of reports thrown away because the ring was full */
+extern unsigned int controller_dropped(void);
+
+/* Cancel the transfer and join the input thread */
+extern void controller_stop(void);
+
 #endif
@@ -0,0 +1,98 @@
+#include "ecs.h"
+
+/* Move the data at from to to in the component with bit b */
+static void move_data(ecs_world *w, int b, int to, int from) {
+
+    body_data *body = &w->body;
+    dive_data *dive = &w->dive;
+
+    if (1 << b == C_BODY) {
+        body->pos_x[to] = body->pos_x[from];
+        body->pos_y[to] = body->pos_y[from];
+        body->velo_x[to] = body->velo_x[from];
+        body->velo_y[to] = body->velo_y[from];
+        body->sub_x[to] = body->sub_x[from];
+        body->sub_y[to] = body->sub_y[from];
+        body->sprite[to] = body->sprite[from];
+    }
+
+    else if (1 << b == C_DIVING) {
+        dive->move_time[to] = dive->move_time[from];
+        dive->state[to] = dive->state[from];
+    }
+}
+
+static void clear_data(ecs_world *w, int b, int d) {
+
+    body_data *body = &w->body;
+    dive_data *dive = &w->dive;
+
+    if (1 << b == C_BODY) {
+        body->pos_x[d] = body->pos_y[d] = 0;
+        body->velo_x[d] = body->velo_y[d] = 0;
+        body->sub_x[d] = body->sub_y[d] = 0;
+        body->sprite[d] = 0;
+    }
+
+    else if (1 << b == C_DIVING)
+        dive->move_time[d] = dive->state[d] = 0;
+}
+
+/* The mask is kept in step with the sets, so only the bits that
+   change need their set touched */
+void ecs_add(ecs_world *w, int e, ecs_mask c) {
+
+    for (unsigned int m = c & ~w->mask[e]; m; m &= m - 1) {
+
+        int b = __builtin_ctz(m);
+        ecs_set *s = &w->set[b];
+
+        s->sparse[e] = s->count;
+        s->dense[s->count] = e;
+        clear_data(w, b, s->count++);
+    }
+
+    w->mask[e] |= c;
+}
+
+void ecs_remove(ecs_world *w, int e, ecs_mask c) {
+
+    for (unsigned int m = c & w->mask[e]; m; m &= m - 1) {
+
+        int b = __builtin_ctz(m), d, last;
+        ecs_set *s = &w->set[b];
+
+        d = s->sparse[e];
+        last = --s->count;
+
+        s->dense[d] = s->dense[last];
+        s->sparse[s->dense[d]] = d;
+        move_data(w, b, d, last);
+    }
+
+    w->mask[e] &= ~c;
+}
+
+pool_handle ecs_handle(const ecs_world *w, int e) {
+
+    return (w->gen[e] << 16) | e;
+}
+
+int ecs_entity(const ecs_world *w, pool_handle h) {
+
+    int e;
+
+    if (h < 0) return -1;
+
+    e = h & 0xffff;
+
+    if (e >= ECS_ENTITIES || w->gen[e] != (h >> 16)) return -1;
+
+    return e;
+}
+
+void ecs_retire(ecs_world *w, int e) {
+
+    ecs_remove(w, e, 0xff);
+    w->gen[e] = w->gen[e] % 0x7fff + 1;
+}
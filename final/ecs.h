@@ -0,0 +1,74 @@
+#ifndef _ECS_H
+#define _ECS_H
+
+#include <stdbool.h>
+#include "entities.h"
+
+/*
+ * The components and their sparse sets (the storage is in entities.h).
+ *
+ * Adding a component appends the entity to that component's dense
+ * list; removing one moves the last member into the hole, along with
+ * its data, so both are O(1) and a system that walks a component sees
+ * only its members, packed.  Order within a set is whatever the adds
+ * and removes left, so a system that must pick the lowest-numbered
+ * entity compares the numbers rather than relying on the order.
+ * Loops that may remove what they are walking go from the end:
+ *
+ *     for (n = s->count; n-- > 0;) { e = s->dense[n]; ... }
+ *
+ * Each entity also has a mask of its components, so testing several
+ * at once is one compare, and a generation.  Anything that refers to
+ * an enemy across ticks (emitters, timers) keeps a handle rather than
+ * the number: ecs_retire() bumps the generation, so a handle kept past
+ * the enemy stops resolving instead of pointing at the next one.
+ */
+#define C_BODY       0x01   /* on the field, with its data in ecs_world.body */
+#define C_ACTIVE     0x02   /* drawn; an enemy on screen, the ship in play */
+#define C_FORMATION  0x04   /* an enemy in its place in the formation */
+#define C_DIVING     0x08   /* an enemy out of it, with its data in ecs_world.dive */
+#define C_RETURNING  0x10   /* a diver flying home to its place */
+#define C_EXPLODING  0x20   /* an enemy hit; drawn but no longer in play */
+#define C_RELOADING  0x40   /* an enemy that shot too recently to shoot again */
+#define C_SHOT       0x80   /* a ship bullet in flight */
+
+_Static_assert(ECS_COMPONENTS == 8 && sizeof(ecs_mask) == 1, "one mask bit per component");
+
+/* The set of one component (a single C_* bit) */
+static inline const ecs_set *ecs_members(const ecs_world *w, ecs_mask c) {
+
+    return &w->set[__builtin_ctz(c)];
+}
+
+static inline bool ecs_has(const ecs_world *w, int e, ecs_mask all, ecs_mask none) {
+
+    return (w->mask[e] & (all | none)) == all;
+}
+
+/* Where entity e's data is in component c's arrays; e must have c */
+static inline int ecs_index(const ecs_world *w, ecs_mask c, int e) {
+
+    return w->set[__builtin_ctz(c)].sparse[e];
+}
+
+#define ecs_body(w, e) ecs_index(w, C_BODY, e)
+#define ecs_dive(w, e) ecs_index(w, C_DIVING, e)
+
+/* Give e the components in c it does not have yet.  Their data starts
+   zeroed. */
+extern void ecs_add(ecs_world *, int e, ecs_mask c);
+
+/* Take the components in c off e */
+extern void ecs_remove(ecs_world *, int e, ecs_mask c);
+
+/* Handle to entity e as it is now */
+extern pool_handle ecs_handle(const ecs_world *, int e);
+
+/* Entity a handle refers to, or -1 if it is POOL_NONE or the entity
+   it was taken from is gone */
+extern int ecs_entity(const ecs_world *, pool_handle);
+
+/* e is being emptied: drop its components and its handles */
+extern void ecs_retire(ecs_world *, int e);
+
+#endif
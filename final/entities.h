@@ -0,0 +1,117 @@
+#ifndef _ENTITIES_H
+#define _ENTITIES_H
+
+#include <stdbool.h>
+#include "vga_ball.h"
+#include "pool.h"
+#include "wheel.h"
+#include "fixed.h"
+
+/*
+ * Entities and their components, plus the enemy bullets, which stay a
+ * plain pool (see pattern.h).
+ *
+ * Every enemy, the ship, each ship bullet and the power-up is an
+ * entity: a number below ECS_ENTITIES.  Its range says what kind of
+ * entity it is, and with it which display slot it is drawn into.
+ *
+ * A component is a sparse set (see ecs.h): dense[] packs the entities
+ * that have it, sparse[] maps each entity to its place in dense[].
+ * Components with data keep it in arrays packed the same way, so a
+ * system that walks one component reads its data front to back.
+ * Velocities are Q8.8 pixels per frame (see fixed.h); sub_x/sub_y
+ * carry the fractional part of the position between frames so slow
+ * or shallow angles still move at the right rate.
+ */
+#define ECS_SHIP         ENEMY_COUNT
+#define ECS_SHIP_BULLET  (ECS_SHIP + 1)                /* SHIP_BULLETS of them */
+#define ECS_POWERUP      (ECS_SHIP_BULLET + SHIP_BULLETS)
+#define ECS_ENTITIES     (ECS_POWERUP + 1)
+
+/* One bit each, see C_* in ecs.h */
+#define ECS_COMPONENTS 8
+
+typedef unsigned char ecs_mask;
+
+/* sparse[e] only means something while e's mask has the component's
+   bit, so a zeroed world is empty and stale entries are harmless */
+typedef struct {
+    short count;
+    short dense[ECS_ENTITIES];
+    short sparse[ECS_ENTITIES];
+} ecs_set;
+
+/* C_BODY: on the field.  Where it is, how it moves and its sprite. */
+typedef struct {
+    unsigned short pos_x[ECS_ENTITIES], pos_y[ECS_ENTITIES];
+    short velo_x[ECS_ENTITIES], velo_y[ECS_ENTITIES];
+    unsigned char sub_x[ECS_ENTITIES], sub_y[ECS_ENTITIES];
+    char sprite[ECS_ENTITIES];
+} body_data;
+
+/* C_DIVING: an enemy out of formation, running its script */
+typedef struct {
+    short move_time[ENEMY_COUNT];       /* ticks in its behaviour state */
+    unsigned char state[ENEMY_COUNT];   /* see behaviour.h */
+} dive_data;
+
+typedef struct {
+    ecs_mask mask[ECS_ENTITIES];        /* the components each entity has */
+    unsigned short gen[ECS_ENTITIES];   /* for handles, see ecs.h */
+    ecs_set set[ECS_COMPONENTS];        /* each component's members, by bit */
+    body_data body;                     /* packed as C_BODY's set */
+    dive_data dive;                     /* packed as C_DIVING's set */
+} ecs_world;
+
+/* What only enemies have, indexed by entity */
+typedef struct {
+    short start_x[ENEMY_COUNT], start_y[ENEMY_COUNT];  /* its place in formation */
+    pool_handle bul[ENEMY_COUNT];   /* its bullet in bullet_store.slots */
+    pool_handle emitter[ENEMY_COUNT];   /* its pattern in emitter_store.slots */
+    char row[ENEMY_COUNT], col[ENEMY_COUNT];
+    unsigned char path[ENEMY_COUNT];    /* its dive, in the wave file */
+
+    /* Its pending timers in game_world.timers */
+    pool_handle explosion[ENEMY_COUNT], reload[ENEMY_COUNT];
+} enemy_store;
+
+/* What only the ship has.  Where it is and the pad's push are its
+   body; it is in play while it has C_ACTIVE. */
+typedef struct {
+    short lives, num_buls, explosion_timer;
+} ship_state;
+
+typedef struct {
+    unsigned short pos_x[MAX_BULLETS], pos_y[MAX_BULLETS];
+    short velo_x[MAX_BULLETS], velo_y[MAX_BULLETS];
+    unsigned char sub_x[MAX_BULLETS], sub_y[MAX_BULLETS];
+    bool active[MAX_BULLETS];   /* mirrors slots, for the SIMD kernels */
+    pool slots;
+} bullet_store;
+
+/* Running bullet patterns, at most one per enemy (see pattern.h) */
+#define MAX_EMITTERS ENEMY_COUNT
+
+typedef struct {
+    short x[MAX_EMITTERS], y[MAX_EMITTERS];     /* muzzle, from the owner if any */
+    pool_handle owner[MAX_EMITTERS];            /* enemy it fires from (ecs.h), or POOL_NONE */
+    fix_angle heading[MAX_EMITTERS];
+    short speed[MAX_EMITTERS];                  /* Q8.8 */
+    short wait[MAX_EMITTERS];                   /* ticks until it runs again */
+    unsigned char script[MAX_EMITTERS], pc[MAX_EMITTERS], loops[MAX_EMITTERS];
+    pool slots;
+} emitter_store;
+
+/* Everything the game simulates */
+typedef struct {
+    ecs_world ecs;
+    ship_state ship;
+    bullet_store bullets;       /* the enemies' */
+    emitter_store emitters;
+    enemy_store enemies;
+    bool indicator;             /* the power-up shows the one running */
+    int score;
+    timer_wheel timers;         /* every countdown, in ticks */
+} game_world;
+
+#endif
@@ -0,0 +1,138 @@
+#include "fixed.h"
+
+/* Direction table resolution: steps per 45 degrees */
+#define DIR_BITS 6
+#define DIR_STEPS (1 << DIR_BITS)
+
+/* cos and sin of atan(k / DIR_STEPS) in Q2.14: the unit vector for a
+   direction whose minor axis is k/DIR_STEPS of its major axis */
+static const short dir_major[DIR_STEPS + 1] = {
+    16384, 16382, 16376, 16366, 16352, 16334, 16312, 16287,
+    16257, 16224, 16188, 16147, 16103, 16056, 16006, 15952,
+    15895, 15835, 15772, 15706, 15638, 15567, 15494, 15419,
+    15341, 15261, 15179, 15096, 15010, 14923, 14835, 14745,
+    14654, 14562, 14469, 14375, 14280, 14184, 14088, 13991,
+    13894, 13796, 13698, 13600, 13501, 13403, 13304, 13206,
+    13107, 13009, 12911, 12813, 12716, 12619, 12522, 12426,
+    12330, 12235, 12140, 12046, 11953, 11860, 11768, 11676,
+    11585,
+};
+
+static const short dir_minor[DIR_STEPS + 1] = {
+    0, 256, 512, 767, 1022, 1276, 1529, 1781,
+    2032, 2282, 2529, 2775, 3019, 3261, 3501, 3739,
+    3974, 4206, 4436, 4663, 4887, 5108, 5326, 5541,
+    5753, 5961, 6167, 6368, 6567, 6762, 6954, 7142,
+    7327, 7509, 7687, 7861, 8032, 8200, 8365, 8526,
+    8684, 8838, 8989, 9137, 9282, 9424, 9562, 9698,
+    9830, 9960, 10087, 10211, 10332, 10450, 10566, 10679,
+    10789, 10897, 11002, 11105, 11206, 11304, 11400, 11494,
+    11585,
+};
+
+void fix_aim(int dx, int dy, int speed, short *velo_x, short *velo_y){
+
+    int ax = dx < 0 ? -dx : dx;
+    int ay = dy < 0 ? -dy : dy;
+    int major, minor, k, vx, vy;
+
+    if (!ax && !ay){
+
+        *velo_x = *velo_y = 0;
+        return;
+    }
+
+    /* Reduce to the first octant: the ratio of the shorter axis to the
+       longer one picks the table entry */
+    if (ax >= ay) { major = ax; minor = ay; }
+    else          { major = ay; minor = ax; }
+
+    k = ((minor << DIR_BITS) + major / 2) / major;
+
+    /* speed * Q2.14 unit -> Q8.8 */
+    vx = (speed * dir_major[k] + (1 << 5)) >> 6;
+    vy = (speed * dir_minor[k] + (1 << 5)) >> 6;
+
+    if (ay > ax) { int t = vx; vx = vy; vy = t; }
+
+    *velo_x = dx < 0 ? -vx : vx;
+    *velo_y = dy < 0 ? -vy : vy;
+}
+
+
+/* sin over the first quarter turn in Q2.14, 64 steps */
+static const short quarter_sin[DIR_STEPS + 1] = {
+    0, 402, 804, 1205, 1606, 2006, 2404, 2801,
+    3196, 3590, 3981, 4370, 4756, 5139, 5520, 5897,
+    6270, 6639, 7005, 7366, 7723, 8076, 8423, 8765,
+    9102, 9434, 9760, 10080, 10394, 10702, 11003, 11297,
+    11585, 11866, 12140, 12406, 12665, 12916, 13160, 13395,
+    13623, 13842, 14053, 14256, 14449, 14635, 14811, 14978,
+    15137, 15286, 15426, 15557, 15679, 15791, 15893, 15986,
+    16069, 16143, 16207, 16261, 16305, 16340, 16364, 16379,
+    16384,
+};
+
+/* atan(k / DIR_STEPS) as a binary angle, 0 to an eighth of a turn */
+static const short octant_atan[DIR_STEPS + 1] = {
+    0, 163, 326, 489, 651, 813, 975, 1136,
+    1297, 1457, 1617, 1775, 1933, 2090, 2246, 2401,
+    2555, 2708, 2860, 3010, 3159, 3307, 3453, 3599,
+    3742, 3884, 4025, 4164, 4302, 4438, 4572, 4705,
+    4836, 4966, 5094, 5220, 5344, 5467, 5589, 5708,
+    5826, 5943, 6058, 6171, 6282, 6392, 6500, 6607,
+    6712, 6815, 6917, 7018, 7117, 7214, 7310, 7405,
+    7498, 7589, 7679, 7768, 7856, 7942, 8026, 8110,
+    8192,
+};
+
+/* Linear interpolation in a 65-entry table by a 0 .. 0x4000 index */
+static int lerp_table(const short *t, int w){
+
+    int k = w >> 8, frac = w & 0xff;
+
+    if (k == DIR_STEPS) return t[DIR_STEPS];
+
+    return t[k] + (((t[k + 1] - t[k]) * frac) >> 8);
+}
+
+fix_angle fix_heading(int dx, int dy){
+
+    int ax = dx < 0 ? -dx : dx;
+    int ay = dy < 0 ? -dy : dy;
+    int a;
+
+    if (!ax && !ay) return 0;
+
+    /* The first octant again, then unfold */
+    if (ax >= ay) a = lerp_table(octant_atan, (ay << 14) / ax);
+    else          a = FIX_QUARTER - lerp_table(octant_atan, (ax << 14) / ay);
+
+    if (dx < 0) a = 2 * FIX_QUARTER - a;
+    if (dy < 0) a = -a;
+
+    return (fix_angle) a;
+}
+
+/* sin of a binary angle in Q2.14 */
+static int fix_sin(fix_angle a){
+
+    int w = a & (FIX_QUARTER - 1);
+    int s;
+
+    switch (a >> 14){
+        case 0: s = lerp_table(quarter_sin, w); break;
+        case 1: s = lerp_table(quarter_sin, FIX_QUARTER - w); break;
+        case 2: s = -lerp_table(quarter_sin, w); break;
+        default: s = -lerp_table(quarter_sin, FIX_QUARTER - w); break;
+    }
+
+    return s;
+}
+
+void fix_polar(fix_angle a, int speed, short *velo_x, short *velo_y){
+
+    /* Q8.8 * Q2.14 -> Q8.8, rounded */
+    *velo_x = (speed * fix_sin(a + FIX_QUARTER) + (1 << 13)) >> 14;
+    *velo_y = (speed * fix_sin(a) + (1 << 13)) >> 14;
+}
@@ -0,0 +1,40 @@
+#ifndef _FIXED_H
+#define _FIXED_H
+
+/*
+ * Q8.8 fixed point for enemy and enemy bullet velocities.  Positions
+ * stay in whole pixels with a separate 8-bit fraction (sub_x/sub_y in
+ * the stores), so collision and packing keep working on pixels while
+ * motion accumulates sub-pixel steps.
+ */
+#define FIX_SHIFT 8
+#define FIX_ONE (1 << FIX_SHIFT)
+
+/* n pixels per frame as a Q8.8 velocity */
+#define FIX(n) ((short)((n) * FIX_ONE))
+
+/* Whole pixels of a Q8.8 value, rounded towards minus infinity */
+#define FIX_INT(v) ((v) >> FIX_SHIFT)
+
+/* Velocity of magnitude speed (whole pixels per frame) pointing along
+   dx, dy, from a direction table instead of sqrt and divides.  A zero
+   vector gives a zero velocity. */
+extern void fix_aim(int dx, int dy, int speed, short *velo_x, short *velo_y);
+
+/*
+ * Binary angles: a full turn is 65536, so they wrap for free in an
+ * unsigned short.  0 points along +x and FIX_QUARTER along +y, which
+ * is down the screen.  The high byte alone is a 256-step heading.
+ */
+typedef unsigned short fix_angle;
+
+#define FIX_QUARTER 0x4000
+#define FIX_TURN(n) ((fix_angle)((n) * 65536 / 360))   /* n degrees */
+
+/* Heading of dx, dy; 0 for a zero vector */
+extern fix_angle fix_heading(int dx, int dy);
+
+/* Q8.8 velocity of Q8.8 speed along heading a */
+extern void fix_polar(fix_angle a, int speed, short *velo_x, short *velo_y);
+
+#endif
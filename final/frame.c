@@ -0,0 +1,100 @@
+/*
+ * Userspace side of UPDATE_FRAME: turn the game state into the object
+ * words the display decodes, so the driver only has to copy them out.
+ */
+
+#include <string.h>
+#include "frame.h"
+#include "fixed.h"
+#include "ecs.h"
+
+/* The display slot entity e is drawn into */
+static int slot_of(int e){
+
+    if (e < ECS_SHIP) return ENEMY_SLOT + e;
+
+    if (e == ECS_SHIP) return SHIP_SLOT;
+
+    if (e < ECS_POWERUP) return SHIP_BULLET_SLOT + e - ECS_SHIP_BULLET;
+
+    return POWERUP_SLOT;
+}
+
+static void pack_ship(const ecs_world *w, const ship_state *ship, frame_words *frame){
+
+    const body_data *body = &w->body;
+    int d = ecs_body(w, ECS_SHIP), sprite, i, active;
+    bool in_play = ecs_has(w, ECS_SHIP, C_ACTIVE, 0);
+
+    if (body->sprite[d] == SHIP_EXPLOSION1) sprite = SHIP_EXPLOSION1;
+
+    else if (body->sprite[d] == SHIP_EXPLOSION2) sprite = SHIP_EXPLOSION2;
+
+    else if (body->velo_x[d] < 0) sprite = SHIP_LEFT;
+
+    else if (body->velo_x[d] > 0) sprite = SHIP_RIGHT;
+
+    else sprite = SHIP;
+
+    frame->words[SHIP_SLOT] = OBJECT_WORD(body->pos_x[d], body->pos_y[d], sprite, in_play);
+
+    if (body->velo_y[d] < 0 && in_play && !ship->explosion_timer) active = 1;
+    else active = 0;
+
+    frame->words[FLAME_SLOT] = OBJECT_WORD(body->pos_x[d], body->pos_y[d]+SHIP_HEIGHT, SHIP_FLAME, active);
+
+    for(i = 0; i<LIFE_COUNT; i++){
+
+        if(i<ship->lives) active = 1;
+        else active = 0;
+
+        frame->words[LIFE_SLOT+i] = OBJECT_WORD(i*20+10, SCREEN_HEIGHT-16, SHIP, active);
+    }
+}
+
+/* Every body but the ship's goes straight into its slot; the slots of
+   entities without one are left empty */
+static void pack_bodies(const ecs_world *w, frame_words *frame){
+
+    const ecs_set *bodies = ecs_members(w, C_BODY);
+    const body_data *body = &w->body;
+
+    memset(&frame->words[SHIP_BULLET_SLOT], 0, (SHIP_BULLETS + ENEMY_COUNT) * sizeof(frame->words[0]));
+    frame->words[POWERUP_SLOT] = 0;
+
+    for (int d = 0; d < bodies->count; d++) {
+
+        int e = bodies->dense[d];
+
+        if (e == ECS_SHIP) continue;
+
+        frame->words[slot_of(e)] = OBJECT_WORD(body->pos_x[d], body->pos_y[d], body->sprite[d],
+                                               (w->mask[e] & C_ACTIVE) != 0);
+    }
+}
+
+static void pack_enemy_bullets(const bullet_store *b, frame_words *frame){
+
+    char sprite;
+
+    for (int i = 0; i < MAX_BULLETS; i++) {
+
+        if (b->velo_x[i] <= -FIX_ONE) sprite = ENEMY_BULLET_LEFT;
+
+        else if (b->velo_x[i] >= FIX_ONE) sprite = ENEMY_BULLET_RIGHT;
+
+        else sprite = ENEMY_BULLET;
+
+        frame->words[ENEMY_BULLET_SLOT+i] = OBJECT_WORD(b->pos_x[i], b->pos_y[i], sprite, b->active[i]);
+    }
+}
+
+void pack_frame(const game_world *game_state, frame_words *frame){
+
+    frame->words[0] = 0;
+    frame->words[SCORE_SLOT] = (unsigned int) game_state->score;
+
+    pack_ship(&game_state->ecs, &game_state->ship, frame);
+    pack_bodies(&game_state->ecs, frame);
+    pack_enemy_bullets(&game_state->bullets, frame);
+}
@@ -0,0 +1,12 @@
+#ifndef _FRAME_H
+#define _FRAME_H
+
+#include "vga_ball.h"
+#include "entities.h"
+
+/* Pack everything on screen into the words UPDATE_FRAME writes, using
+   the same sprite choices the driver's write_ship()/write_enemies()
+   make. */
+extern void pack_frame(const game_world *, frame_words *);
+
+#endif
@@ -0,0 +1,104 @@
+#include "frame_timer.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+
+#define NSEC_PER_SEC 1000000000L
+
+static void timespec_add(struct timespec *t, long ns) {
+
+  t->tv_nsec += ns;
+
+  while (t->tv_nsec >= NSEC_PER_SEC) {
+    t->tv_nsec -= NSEC_PER_SEC;
+    t->tv_sec++;
+  }
+}
+
+/* a - b in nanoseconds */
+static long long timespec_diff(const struct timespec *a,
+                               const struct timespec *b) {
+  return (long long)(a->tv_sec - b->tv_sec) * NSEC_PER_SEC +
+         (a->tv_nsec - b->tv_nsec);
+}
+
+void frame_timer_start(frame_timer *timer, long period_ns) {
+
+  timer->period = period_ns;
+  timer->ticks = timer->frames = timer->missed = timer->dropped = 0;
+  timer->vblank_fd = -1;
+
+  clock_gettime(CLOCK_MONOTONIC, &timer->next);
+  timespec_add(&timer->next, period_ns);
+}
+
+int frame_timer_use_vblank(frame_timer *timer, int fd) {
+
+  struct pollfd pfd = { .fd = fd, .events = POLLIN };
+  unsigned int count;
+
+  if (poll(&pfd, 1, 3 * timer->period / 1000000) != 1 ||
+      !(pfd.revents & POLLIN) ||
+      read(fd, &count, sizeof(count)) != sizeof(count))
+    return -1;
+
+  timer->vblank_fd = fd;
+  timer->vblank = timer->vblank_done = count;
+  return 0;
+}
+
+int frame_timer_steps(frame_timer *timer) {
+
+  struct timespec now;
+  long long late;
+  long due;
+
+  timer->frames++;
+
+  if (timer->vblank_fd >= 0) {
+
+    /* One tick per scanout since the last call */
+    if ((due = timer->vblank - timer->vblank_done) == 0) return 0;
+
+    timer->vblank_done = timer->vblank;
+    timer->missed += due - 1;
+  }
+  else {
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if ((late = timespec_diff(&now, &timer->next)) < 0) return 0;
+
+    /* Every deadline between next and now is due */
+    due = late / timer->period + 1;
+
+    timer->missed += due - 1;
+    timespec_add(&timer->next, due * timer->period);
+  }
+
+  /* Too far behind to catch up: skip the rest instead of spiralling */
+  if (due > MAX_CATCHUP) {
+    timer->dropped += due - MAX_CATCHUP;
+    due = MAX_CATCHUP;
+  }
+
+  timer->ticks += due;
+  return due;
+}
+
+void frame_timer_wait(frame_timer *timer) {
+
+  unsigned int count;
+
+  /* read() returns as soon as there is a vblank we have not seen */
+  if (timer->vblank_fd >= 0) {
+    if (read(timer->vblank_fd, &count, sizeof(count)) == sizeof(count))
+      timer->vblank = count;
+    return;
+  }
+
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &timer->next,
+                         NULL) == EINTR)
+    ;
+}
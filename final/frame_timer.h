@@ -0,0 +1,48 @@
+#ifndef _FRAME_TIMER_H
+#define _FRAME_TIMER_H
+
+#include <time.h>
+
+/* Simulation and commit rate */
+#define FRAME_HZ 60
+#define FRAME_NS (1000000000L / FRAME_HZ)
+
+/* Most simulation ticks run back to back to catch up after an overrun */
+#define MAX_CATCHUP 4
+
+/*
+ * Fixed-timestep scheduler on absolute CLOCK_MONOTONIC deadlines.
+ * Work done inside a frame never pushes the next deadline back, so the
+ * period does not drift with how long the frame took.
+ *
+ * When the display raises a vblank interrupt the timer can follow it
+ * instead: one simulation tick per scanout, with the vblank count from
+ * /dev/vga_ball telling how many scanouts went by.
+ */
+typedef struct {
+    struct timespec next;   /* deadline of the next simulation tick */
+    long period;            /* nanoseconds per tick */
+    unsigned long ticks;    /* simulation ticks handed out */
+    unsigned long frames;   /* calls to frame_timer_steps() */
+    unsigned long missed;   /* deadlines that passed before we got to them */
+    unsigned long dropped;  /* ticks skipped because they exceeded MAX_CATCHUP */
+    int vblank_fd;          /* display to follow, -1 for the clock */
+    unsigned int vblank;    /* last vblank count read from vblank_fd */
+    unsigned int vblank_done; /* vblank count the simulation has reached */
+} frame_timer;
+
+/* Reset counters and put the first deadline one period from now */
+extern void frame_timer_start(frame_timer *, long period_ns);
+
+/* Follow the vblanks of an open /dev/vga_ball.  Returns 0 if the
+   device delivered a vblank within a few periods, -1 (and keeps using
+   the clock) if not. */
+extern int frame_timer_use_vblank(frame_timer *, int fd);
+
+/* Number of simulation ticks due now, between 0 and MAX_CATCHUP */
+extern int frame_timer_steps(frame_timer *);
+
+/* Sleep until the next deadline or vblank */
+extern void frame_timer_wait(frame_timer *);
+
+#endif
@@ -0,0 +1,1512 @@
+/*
+ * CSEE 4840 Lab 2 for 2019
+ *
+ * Name/UNI:Noah Hartzfeld (nah2178)
+            Zhengtao Hu (zh2651)
+            Mingzhi Li (ml5160)
+*/
+
+/*
+ * The game itself: everything that runs once per simulation tick.
+ * Nothing in here touches the device or the pad, so the same code runs
+ * on the board and in the headless build.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vga_ball.h"
+#include "game.h"
+#include "frame.h"
+#include "grid.h"
+#include "entities.h"
+#include "simd.h"
+#include "fixed.h"
+#include "wheel.h"
+#include "behaviour.h"
+#include "pattern.h"
+#include "wave.h"
+#include "ecs.h"
+#include "trace.h"
+
+
+// #define SCREEN_WIDTH 1280
+
+
+#define COLOR_COUNT 5
+
+#define SHIP_INITIAL_X 300
+#define SHIP_INITIAL_Y 400
+
+#define BULLET_WIDTH 8
+#define BULLET_HEIGHT 4
+
+
+#define ENEMY_WIDTH 16
+#define ENEMY_HEIGHT 16
+
+#define ENEMY_SPACE 10
+
+#define ENEMY3_BULLET_COOLDOWN 50
+
+#define ENEMY4_BULLET_COOLDOWN 40
+
+
+/* The rounds, from the wave file game_init() was given */
+static const wave_file *waves;
+
+/* Bit c of row_mask[r] is set while the enemy at row r, column c has
+   C_FORMATION.  row_slot maps a row and column back to the enemy, -1
+   where there is none. */
+_Static_assert(MAX_COLUMNS <= 32, "row_mask has one bit per column");
+static unsigned int row_mask[MAX_ROWS];
+static short row_slot[MAX_ROWS][MAX_COLUMNS];
+
+/* The rows each enemy type dives from, going by each row's first
+   enemy, indexed by sprite - ENEMY1 */
+#define ENEMY_TYPES 3
+_Static_assert(ENEMY2 - ENEMY1 < ENEMY_TYPES && ENEMY3 - ENEMY1 < ENEMY_TYPES,
+               "enemy sprites are numbered together");
+static unsigned char launch_rows[ENEMY_TYPES][MAX_ROWS], launch_count[ENEMY_TYPES];
+
+
+static int kill_count = 0;
+
+static int ship_velo = 2;
+
+/* Which fire buttons handle_input() saw held last, so holding one
+   down fires only once */
+static int prev_bullet = 0, bumpers = 0, buttons = 0;
+
+/* A power-up lasts this long; the indicator starts blinking BLINK_TIME
+   ticks before it runs out, faster for the last QUICK_BLINK_TIME */
+static pool_handle powerup_timer = POOL_NONE, blink_timer = POOL_NONE;
+#define EXTRA_BULLET_TIME 300
+#define EXTRA_SPEED_TIME 750
+#define BLINK_TIME 100
+#define QUICK_BLINK_TIME 50
+#define BLINK_COUNT 10
+#define QUICK_BLINK_COUNT 5
+
+
+/* An explosion shows SHIP_EXPLOSION1 from the tick after the hit,
+   SHIP_EXPLOSION2 from EXPLOSION_FADE ticks after it, and is gone
+   EXPLOSION_TIME ticks after it */
+#define EXPLOSION_TIME 10
+#define EXPLOSION_FADE 7
+
+
+static int enemy_wiggle = 1;
+static int enemy_wiggle_time = 0;
+
+/* Level of detail the frame-budget watchdog asked for.  At
+   GAME_DETAIL_LOW the formation only moves every FORMATION_EVERY ticks
+   and formation_lag is how far its wiggle has run ahead meanwhile. */
+static int detail = GAME_DETAIL_FULL;
+static int formation_lag = 0;
+#define FORMATION_EVERY 4
+
+
+static int moving = 300;
+
+/* Array of background colors to cycle through */
+static const background_color colors[] = {
+    { 0x00, 0x00, 0x10 },  // Very dark blue
+    { 0x00, 0x00, 0x20 },  // Dark blue
+    { 0x10, 0x10, 0x30 },  // Navy blue
+    { 0x00, 0x00, 0x40 },  // Medium blue
+    { 0x20, 0x20, 0x40 }   // Blue-purple
+};
+
+
+/*
+ * After a life is lost or a round is cleared the game waits ROUND_WAIT
+ * ticks, then for the field to empty, then respawns the ship or brings
+ * the next formation on.
+ */
+enum { ROUND_PLAYING, ROUND_WAITING, ROUND_SETTLED, ROUND_STARTING };
+static int round_phase = ROUND_PLAYING;
+static pool_handle round_timer = POOL_NONE;
+static long round_time = 0;
+static int active1 = 0, active2 = 0, active3 = 0, round_pause, num_sent, send_per_round = 20;
+#define TOTAL_ACTIVE (active1 + active2 + active3)
+#define ROUND_WAIT 64
+static int round_num = 1;
+static int enemies_remaining, col_active = 0;
+
+
+/* What a timer on game_state.timers does when it fires, see fire_timer() */
+enum {
+    TIMER_ENEMY_EXPLODE,    /* arg is the enemy's handle (ecs.h) */
+    TIMER_ENEMY_FADE,
+    TIMER_ENEMY_GONE,
+    TIMER_ENEMY_RELOADED,
+    TIMER_ENEMY_LAST = TIMER_ENEMY_RELOADED,
+    TIMER_SHIP_EXPLODE,
+    TIMER_SHIP_FADE,
+    TIMER_SHIP_GONE,
+    TIMER_POWERUP_BLINK,
+    TIMER_POWERUP_OVER,
+    TIMER_ROUND_SETTLED,
+};
+
+_Static_assert(GAME_TIMERS <= POOL_CAPACITY, "the timer wheel holds every countdown");
+
+
+
+static game_world game_state = {
+
+    .ship = {.lives = LIFE_COUNT, .num_buls = 5},
+    .bullets = { 0 },
+    .enemies = { 0 },
+    .indicator = 0,
+    .score = 0
+};
+
+/* Entity e's place in the C_BODY arrays, and whether it has all of c */
+#define BODY(e) ecs_body(&game_state.ecs, e)
+#define HAS(e, c) ecs_has(&game_state.ecs, e, c, 0)
+
+/* Pack the current state into the words the display decodes */
+void game_pack(frame_words *frame) {
+
+    pack_frame(&game_state, frame);
+}
+
+
+
+/* FNV-1a over n bytes, continuing from hash */
+static unsigned int fnv1a(unsigned int hash, const void *data, size_t n) {
+
+    const unsigned char *p = data;
+
+    while (n--) hash = (hash ^ *p++) * 16777619u;
+
+    return hash;
+}
+
+/* Fold one field into hash.  The checksum goes field by field, never
+   over a whole struct, so padding never reaches it. */
+#define HASH(x) (hash = fnv1a(hash, &(x), sizeof(x)))
+
+static unsigned int hash_pool(unsigned int hash, const pool *p) {
+
+    HASH(p->capacity); HASH(p->count); HASH(p->free_count);
+    HASH(p->free_slots); HASH(p->live); HASH(p->live_pos); HASH(p->gen);
+
+    return hash;
+}
+
+static unsigned int hash_set(unsigned int hash, const ecs_set *s) {
+
+    HASH(s->count); HASH(s->dense); HASH(s->sparse);
+
+    return hash;
+}
+
+static unsigned int hash_world(unsigned int hash, const game_world *w) {
+
+    const ecs_world *ecs = &w->ecs;
+    const body_data *body = &ecs->body;
+    const ship_state *ship = &w->ship;
+    const bullet_store *b = &w->bullets;
+    const emitter_store *em = &w->emitters;
+    const enemy_store *e = &w->enemies;
+    const timer_wheel *t = &w->timers;
+
+    HASH(ecs->mask); HASH(ecs->gen);
+    for (int c = 0; c < ECS_COMPONENTS; c++) hash = hash_set(hash, &ecs->set[c]);
+    HASH(body->pos_x); HASH(body->pos_y); HASH(body->velo_x); HASH(body->velo_y);
+    HASH(body->sub_x); HASH(body->sub_y); HASH(body->sprite);
+    HASH(ecs->dive.move_time); HASH(ecs->dive.state);
+
+    HASH(ship->lives); HASH(ship->num_buls); HASH(ship->explosion_timer);
+
+    HASH(b->pos_x); HASH(b->pos_y); HASH(b->velo_x); HASH(b->velo_y);
+    HASH(b->sub_x); HASH(b->sub_y); HASH(b->active);
+    hash = hash_pool(hash, &b->slots);
+
+    HASH(em->x); HASH(em->y); HASH(em->owner); HASH(em->heading); HASH(em->speed);
+    HASH(em->wait); HASH(em->script); HASH(em->pc); HASH(em->loops);
+    hash = hash_pool(hash, &em->slots);
+
+    HASH(e->start_x); HASH(e->start_y); HASH(e->bul); HASH(e->emitter);
+    HASH(e->row); HASH(e->col); HASH(e->path);
+    HASH(e->explosion); HASH(e->reload);
+
+    HASH(w->indicator);
+    HASH(w->score);
+
+    HASH(t->now); HASH(t->expires); HASH(t->event); HASH(t->level);
+    HASH(t->arg); HASH(t->next); HASH(t->prev); HASH(t->head);
+    hash = hash_pool(hash, &t->timers);
+
+    return hash;
+}
+
+/* Hash of everything a tick reads: the world, the formation and the
+   round and input state kept outside it.  Two runs that agree on this
+   every tick took the same path. */
+unsigned int game_checksum() {
+
+    int counters[] = {
+        kill_count, powerup_timer, blink_timer, enemy_wiggle,
+        enemy_wiggle_time, round_phase, round_timer,
+        detail, formation_lag,
+        (int) round_time, num_sent, round_num,
+        active1, active2, active3, round_pause, send_per_round,
+        ship_velo, prev_bullet, bumpers, buttons,
+        enemies_remaining, col_active,
+    };
+    unsigned int hash = 2166136261u;
+
+    hash = hash_world(hash, &game_state);
+    HASH(row_mask);
+    HASH(row_slot);
+    HASH(launch_rows);
+    HASH(launch_count);
+    HASH(counters);
+
+    return hash;
+}
+
+#undef HASH
+
+
+
+/* Run a power-up for duration ticks, replacing any that is running */
+void powerup_start(unsigned int duration){
+
+    wheel_cancel(&game_state.timers, powerup_timer);
+    wheel_cancel(&game_state.timers, blink_timer);
+
+    powerup_timer = wheel_add(&game_state.timers, duration, TIMER_POWERUP_OVER, 0);
+    blink_timer = wheel_add(&game_state.timers, duration - BLINK_TIME, TIMER_POWERUP_BLINK, 0);
+}
+
+void apply_powerup(char sprite){
+
+    ship_state *ship = &game_state.ship;
+
+    switch (sprite){
+
+        case EXTRA_LIFE:
+
+            ship->lives++;
+
+            // draw an extra ship life
+            break;
+
+        case SHIP_SPEED:
+
+            ship_velo = 3;
+            powerup_start(EXTRA_SPEED_TIME);
+            break;
+
+        case EXTRA_BULLETS:
+
+            ship->num_buls = 3;
+            powerup_start(EXTRA_BULLET_TIME);
+            break;
+    }
+}
+
+/* Toggle the indicator and come back sooner as the end nears */
+void powerup_blink(){
+
+    unsigned int left = wheel_remaining(&game_state.timers, powerup_timer);
+    unsigned int next = left > QUICK_BLINK_TIME ? BLINK_COUNT + 1 : QUICK_BLINK_COUNT + 1;
+
+    if (HAS(ECS_POWERUP, C_ACTIVE))
+        ecs_remove(&game_state.ecs, ECS_POWERUP, C_ACTIVE);
+
+    else
+        ecs_add(&game_state.ecs, ECS_POWERUP, C_ACTIVE);
+
+    blink_timer = next < left ?
+        wheel_add(&game_state.timers, next, TIMER_POWERUP_BLINK, 0) : POOL_NONE;
+}
+
+/* Take the power-up's effects back off the ship */
+void powerup_over(){
+
+    wheel_cancel(&game_state.timers, powerup_timer);
+    wheel_cancel(&game_state.timers, blink_timer);
+    powerup_timer = blink_timer = POOL_NONE;
+
+    ecs_remove(&game_state.ecs, ECS_POWERUP, C_ACTIVE);
+    game_state.ship.num_buls = 5;
+    ship_velo = 2;
+}
+
+void move_powerup(){
+
+    ecs_world *w = &game_state.ecs;
+    body_data *body = &w->body;
+    int p = BODY(ECS_POWERUP), s = BODY(ECS_SHIP);
+
+    if (HAS(ECS_POWERUP, C_ACTIVE) && !game_state.indicator){
+
+        body->pos_y[p] += FIX_INT(body->velo_y[p]);
+
+        if (HAS(ECS_SHIP, C_ACTIVE) && 
+            abs(body->pos_x[s] - body->pos_x[p]) <= SHIP_WIDTH &&
+            abs(body->pos_y[s] - body->pos_y[p]) <= SHIP_HEIGHT){
+
+            apply_powerup(body->sprite[p]);
+            
+            if(body->sprite[p] == EXTRA_LIFE)
+                ecs_remove(w, ECS_POWERUP, C_ACTIVE);
+
+            body->pos_x[p] = 400;
+            body->pos_y[p] = SCREEN_HEIGHT-SHIP_HEIGHT;
+            game_state.indicator = 1;
+
+
+            kill_count = 0;
+        }
+
+        if (body->pos_y[p] >= SCREEN_HEIGHT){
+
+            ecs_remove(w, ECS_POWERUP, C_ACTIVE);
+            kill_count = 10;
+        }
+
+    }
+
+}
+
+void drop_powerup(int i){
+
+    body_data *body = &game_state.ecs.body;
+    int p = BODY(ECS_POWERUP), pick = rand() % 3;
+
+    if (game_state.ship.lives == LIFE_COUNT && pick == 2)
+        while (pick == 2) pick = rand() % 3;
+
+    body->pos_x[p] = body->pos_x[BODY(i)];
+
+    game_state.indicator = 0;
+
+    body->pos_y[p] = 200;
+    body->velo_y[p] = FIX(1);
+    ecs_add(&game_state.ecs, ECS_POWERUP, C_ACTIVE);
+
+    switch (pick){
+        case 0:
+            body->sprite[p] = SHIP_SPEED;
+
+            break;
+
+        case 1:
+            body->sprite[p] = EXTRA_BULLETS;
+            break;
+
+        case 2:
+            body->sprite[p] = EXTRA_LIFE;
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+
+void change_active_amount(char enemy_sprite){
+
+    switch(enemy_sprite){
+
+        case ENEMY1:
+            active1 --;
+            break;
+
+        case ENEMY2:
+            active2 --;
+            break;
+
+        case ENEMY3:
+            active3 --;
+            break;
+    }
+}
+
+
+void change_score(char sprite){
+
+    switch(sprite){
+
+        case ENEMY1:
+            game_state.score += 20;
+            break;
+
+        case ENEMY2:
+            game_state.score += 10;
+            break;
+
+        case ENEMY3:
+            game_state.score += 5;
+            break;
+
+        case SHIP:
+            game_state.score -= 50;
+    }
+
+
+    if(game_state.score < 0) game_state.score = 0;
+
+}
+
+
+/* Point enemy i at target_x, target_y at speed pixels per frame */
+void aim_enemy(int i, int target_x, int target_y, short speed){
+
+    body_data *body = &game_state.ecs.body;
+    int d = BODY(i);
+
+    fix_aim(target_x - body->pos_x[d], target_y - body->pos_y[d], speed, &body->velo_x[d], &body->velo_y[d]);
+}
+
+
+/* Enemy i is back in (or newly in) formation */
+void formation_join(int i){
+
+    enemy_store *e = &game_state.enemies;
+
+    row_mask[(int) e->row[i]] |= 1u << e->col[i];
+    ecs_add(&game_state.ecs, i, C_FORMATION);
+}
+
+/* Enemy i dove, died or started exploding */
+void formation_leave(int i){
+
+    enemy_store *e = &game_state.enemies;
+
+    row_mask[(int) e->row[i]] &= ~(1u << e->col[i]);
+    ecs_remove(&game_state.ecs, i, C_FORMATION);
+}
+
+/* The leftmost (front) or rightmost enemy still in formation in row,
+   or -1 if the row is empty */
+int formation_end(int row, int front){
+
+    unsigned int mask = row_mask[row];
+
+    if (!mask) return -1;
+
+    return row_slot[row][front ? __builtin_ctz(mask) : 31 - __builtin_clz(mask)];
+}
+
+/* Bring every enemy in column col on screen */
+void activate_column(int col){
+
+    int i;
+
+    for (int row = 0; row < waves->header->rows; row++){
+
+        if ((i = row_slot[row][col]) == -1) continue;
+
+        ecs_add(&game_state.ecs, i, C_ACTIVE);
+        formation_join(i);
+    }
+}
+
+
+
+/* Have enemy i fire script from under it.  Returns 0 if no emitter is
+   free or i's last pattern is still running. */
+int enemy_fire(int i, int script){
+
+    return pattern_start(&game_state, script, i, 0, ENEMY_HEIGHT) != POOL_NONE;
+}
+
+/* Enemy bullet k is gone.  The firing enemy's handle goes stale with it. */
+void release_enemy_bul(int k){
+
+    bullet_store *b = &game_state.bullets;
+
+    b->active[k] = 0;
+    pool_release(&b->slots, k);
+}
+
+
+/* Keep enemy i from shooting for the next cooldown ticks */
+void enemy_reload(int i, int cooldown){
+
+    enemy_store *e = &game_state.enemies;
+
+    ecs_add(&game_state.ecs, i, C_RELOADING);
+    e->reload[i] = wheel_add(&game_state.timers, cooldown + 1, TIMER_ENEMY_RELOADED,
+                             ecs_handle(&game_state.ecs, i));
+}
+
+
+void enemy_shoot(int i){
+
+    ecs_world *w = &game_state.ecs;
+    body_data *body = &w->body;
+    enemy_store *e = &game_state.enemies;
+    bullet_store *b = &game_state.bullets;
+    int d = BODY(i), s = BODY(ECS_SHIP);
+
+    if (HAS(ECS_SHIP, C_ACTIVE) && ecs_has(w, i, C_DIVING, C_RELOADING | C_RETURNING) &&
+        behaviour_states[w->dive.state[ecs_dive(w, i)]].armed){
+
+        if (body->sprite[d] == ENEMY2){
+
+            if (abs(body->pos_x[s] - body->pos_x[d]) <= 80
+                    && abs(body->pos_y[s] - body->pos_y[d]) <= 150
+                    && body->pos_y[s] - 30 > body->pos_y[d]){
+
+                if (pool_slot(&b->slots, e->bul[i]) == -1){
+
+                    if (enemy_fire(i, PATTERN_DROP))
+                        enemy_reload(i, ENEMY3_BULLET_COOLDOWN);
+                }
+            }
+        }
+
+        else if(body->sprite[d] == ENEMY3){
+
+            if (abs(body->pos_x[s] - body->pos_x[d]) <= 150
+                && abs(body->pos_y[s] - body->pos_y[d] <= 200
+                && body->pos_y[s] - 60 > body->pos_y[d])){
+
+                if (pool_slot(&b->slots, e->bul[i]) == -1){
+
+                    if (enemy_fire(i, PATTERN_FAN))
+                        enemy_reload(i, ENEMY4_BULLET_COOLDOWN);
+                }
+            }
+        }
+    }
+}
+
+
+void enemy_return (int i){
+
+    ecs_world *w = &game_state.ecs;
+    body_data *body = &w->body;
+    enemy_store *e = &game_state.enemies;
+    int d = BODY(i);
+
+
+    if (body->pos_y[d] > SCREEN_HEIGHT || body->pos_x[d] > SCREEN_WIDTH || body->pos_x[d] < 0){
+
+        ecs_add(w, i, C_RETURNING);
+
+        body->pos_x[d] = e->start_x[i];
+        body->pos_y[d] = 0;
+        body->sub_x[d] = body->sub_y[d] = 0;
+
+        aim_enemy(i, e->start_x[i] + enemy_wiggle_time, e->start_y[i], 2);
+    }
+
+    
+    if (HAS(i, C_RETURNING)){
+
+        if (abs(body->pos_x[d] - e->start_x[i] + enemy_wiggle_time) < 25 && abs(body->pos_y[d] -e->start_y[i]) < 25){
+
+            body->pos_x[d] = e->start_x[i]+enemy_wiggle_time-formation_lag;
+            body->pos_y[d] = e->start_y[i];
+            body->sub_x[d] = body->sub_y[d] = 0;
+
+            body->velo_x[d] = 0;
+            body->velo_y[d] = 0;
+
+            /* Its script goes with the C_DIVING data */
+            ecs_remove(w, i, C_DIVING | C_RETURNING);
+
+        }
+
+        else 
+            aim_enemy(i, e->start_x[i] + enemy_wiggle_time, e->start_y[i], 2);
+
+    }
+
+}
+
+
+/*
+ * Retire enemy i and zero what enemy_store keeps for it
+ */
+void clear_enemy(int i){
+
+    enemy_store *e = &game_state.enemies;
+
+    ecs_retire(&game_state.ecs, i);
+    e->start_x[i] = e->start_y[i] = 0;
+    e->bul[i] = e->emitter[i] = POOL_NONE;
+    e->row[i] = e->col[i] = 0;
+    e->path[i] = 0;
+
+    wheel_cancel(&game_state.timers, e->explosion[i]);
+    wheel_cancel(&game_state.timers, e->reload[i]);
+    e->explosion[i] = e->reload[i] = POOL_NONE;
+}
+
+
+/* Start blowing up enemy i.  It drops out of play where it is and is
+   cleared EXPLOSION_TIME ticks from now. */
+void enemy_explode(int i){
+
+    ecs_world *w = &game_state.ecs;
+    enemy_store *e = &game_state.enemies;
+
+    ecs_remove(w, i, C_DIVING | C_RETURNING);
+    ecs_add(w, i, C_EXPLODING);
+    e->explosion[i] = wheel_add(&game_state.timers, 1, TIMER_ENEMY_EXPLODE, ecs_handle(w, i));
+}
+
+/* The ship's explosion.  explosion_timer only marks it as exploding;
+   the wheel does the counting. */
+void ship_explode(){
+
+    game_state.ship.explosion_timer = 1;
+    wheel_add(&game_state.timers, 1, TIMER_SHIP_EXPLODE, 0);
+}
+
+/* Wait out ROUND_WAIT before the next life or round, starting over if
+   already waiting */
+void round_wait(){
+
+    wheel_cancel(&game_state.timers, round_timer);
+
+    round_phase = ROUND_WAITING;
+    round_timer = wheel_add(&game_state.timers, ROUND_WAIT, TIMER_ROUND_SETTLED, 0);
+}
+
+/* The ship loses a life */
+void ship_hit(){
+
+    game_state.ship.lives --;
+
+    ship_explode();
+    round_wait();
+}
+
+void fire_timer(int event, int arg){
+
+    ecs_world *w = &game_state.ecs;
+    body_data *body = &w->body;
+    enemy_store *e = &game_state.enemies;
+    timer_wheel *timers = &game_state.timers;
+    int i = ecs_entity(w, arg);
+
+    /* An enemy timer that outlived its enemy */
+    if (event <= TIMER_ENEMY_LAST && i == -1) return;
+
+    switch (event){
+
+        case TIMER_ENEMY_EXPLODE:
+            body->velo_x[BODY(i)] = 0;
+            body->velo_y[BODY(i)] = 0;
+            body->sprite[BODY(i)] = SHIP_EXPLOSION1;
+            e->explosion[i] = wheel_add(timers, EXPLOSION_FADE - 1, TIMER_ENEMY_FADE, arg);
+            break;
+
+        case TIMER_ENEMY_FADE:
+            body->sprite[BODY(i)] = SHIP_EXPLOSION2;
+            e->explosion[i] = wheel_add(timers, EXPLOSION_TIME - EXPLOSION_FADE, TIMER_ENEMY_GONE, arg);
+            break;
+
+        case TIMER_ENEMY_GONE:
+            clear_enemy(i);
+            break;
+
+        case TIMER_ENEMY_RELOADED:
+            ecs_remove(w, i, C_RELOADING);
+            break;
+
+        case TIMER_SHIP_EXPLODE:
+            body->sprite[BODY(ECS_SHIP)] = SHIP_EXPLOSION1;
+            wheel_add(timers, EXPLOSION_FADE - 1, TIMER_SHIP_FADE, 0);
+            break;
+
+        case TIMER_SHIP_FADE:
+            body->sprite[BODY(ECS_SHIP)] = SHIP_EXPLOSION2;
+            wheel_add(timers, EXPLOSION_TIME - EXPLOSION_FADE, TIMER_SHIP_GONE, 0);
+            break;
+
+        case TIMER_SHIP_GONE:
+            ecs_remove(w, ECS_SHIP, C_ACTIVE);
+            game_state.ship.explosion_timer = 0;
+            body->sprite[BODY(ECS_SHIP)] = SHIP;
+            break;
+
+        case TIMER_POWERUP_BLINK:
+            powerup_blink();
+            break;
+
+        case TIMER_POWERUP_OVER:
+            powerup_over();
+            break;
+
+        case TIMER_ROUND_SETTLED:
+            if (round_phase == ROUND_WAITING) round_phase = ROUND_SETTLED;
+            break;
+    }
+}
+
+
+
+/* Broadphase for everything that collides with enemies */
+static grid enemy_grid;
+
+/*
+ * Rebuild enemy_grid from the enemies that can currently be hit: the
+ * formation and the divers
+ */
+void build_enemy_grid(){
+
+    static const ecs_mask in_play[] = { C_FORMATION, C_DIVING };
+    const ecs_world *w = &game_state.ecs;
+    const ecs_set *set;
+    int i;
+
+    grid_clear(&enemy_grid);
+
+    for (int c = 0; c < 2; c++){
+
+        set = ecs_members(w, in_play[c]);
+
+        for (int n = 0; n < set->count; n++){
+
+            i = set->dense[n];
+            grid_insert(&enemy_grid, i, w->body.pos_x[BODY(i)], w->body.pos_y[BODY(i)]);
+        }
+    }
+}
+
+/*
+ * Lowest-numbered enemy from enemy_grid that overlaps x, y within
+ * half_w, half_h, or -1.  Taking the lowest number keeps the result
+ * the same whatever order the grid and the sets list them in.
+ */
+int find_enemy_hit(int x, int y, int half_w, int half_h){
+
+    short near[GRID_CAPACITY];
+    int found, hit = -1, i, d;
+    const ecs_world *w = &game_state.ecs;
+
+    found = grid_query(&enemy_grid, x, y, half_w, half_h, near, GRID_CAPACITY);
+
+    for (int k = 0; k < found; k++){
+
+        i = near[k];
+        d = BODY(i);
+
+        if ((w->mask[i] & (C_FORMATION | C_DIVING)) &&
+            abs(w->body.pos_x[d] - x) <= half_w &&
+            abs(w->body.pos_y[d] - y) <= half_h &&
+            (hit == -1 || i < hit))
+
+            hit = i;
+    }
+
+    return hit;
+}
+
+/*
+ * Ship against the enemies in play at their new positions; live has a
+ * flag per C_BODY index.  Returns 1 if an enemy rammed the ship and
+ * was destroyed.
+ */
+int ship_colision(const bool *live){
+
+    ecs_world *w = &game_state.ecs;
+    const ecs_set *bodies = ecs_members(w, C_BODY);
+    unsigned char hits[HIT_MASK_BYTES(ECS_ENTITIES)];
+    int s = BODY(ECS_SHIP), i = -1;
+
+    if (!HAS(ECS_SHIP, C_ACTIVE) || game_state.ship.explosion_timer) return 0;
+
+    if (!simd_hit_mask(w->body.pos_x, w->body.pos_y, live, bodies->count,
+                       w->body.pos_x[s], w->body.pos_y[s], SHIP_WIDTH, SHIP_HEIGHT, hits))
+        return 0;
+
+    /* Lowest-numbered, whatever order the bodies are in */
+    for (int d = 0; d < bodies->count; d++)
+        if (HIT(hits, d) && (i == -1 || bodies->dense[d] < i)) i = bodies->dense[d];
+
+    formation_leave(i);
+
+    change_active_amount(w->body.sprite[BODY(i)]);
+
+    clear_enemy(i);
+
+    change_score(SHIP);
+
+    ship_hit();
+
+    return 1;
+}
+
+
+int enemy_movement(int rand_enemy){
+
+    int type, i, d;
+    ecs_world *w = &game_state.ecs;
+    body_data *body = &w->body;
+    enemy_store *e = &game_state.enemies;
+    const ecs_set *bodies = ecs_members(w, C_BODY);
+    const ecs_set *divers = ecs_members(w, C_DIVING), *formation = ecs_members(w, C_FORMATION);
+    bool diving[ECS_ENTITIES], in_formation[ECS_ENTITIES], live[ECS_ENTITIES];
+
+    /* From the end of one of its type's rows */
+    if (rand_enemy != -1){
+
+        type = rand_enemy - ENEMY1;
+
+        if (!launch_count[type])
+            rand_enemy = -1;
+
+        else if (launch_count[type] == 1)
+            rand_enemy = formation_end(launch_rows[type][0], enemy_wiggle > 0);
+
+        else
+            rand_enemy = formation_end(launch_rows[type][rand() % launch_count[type]],
+                                       enemy_wiggle > 0);
+    }
+
+    /* Launch the chosen diver */
+    if (rand_enemy != -1 && HAS(rand_enemy, C_FORMATION)){
+
+        i = rand_enemy;
+        d = BODY(i);
+
+        formation_leave(i);
+
+        /* Divers are never shifted with the formation, so at
+           GAME_DETAIL_LOW catch this one up with the wiggle the
+           formation has not applied yet or it dives from a stale spot */
+        body->pos_x[d] += formation_lag;
+
+        body->velo_x[d] = FIX((e->start_x[i] < SCREEN_WIDTH/2) ? -1 : 1);
+        body->velo_y[d] = FIX(-4);
+
+        ecs_add(w, i, C_DIVING);
+        w->dive.state[ecs_dive(w, i)] = behaviour_start(body->sprite[d]);
+    }
+
+    /* The kernels take a flag per body, so mark where the divers' and
+       the formation's bodies are */
+    memset(diving, 0, bodies->count * sizeof(diving[0]));
+    memset(in_formation, 0, bodies->count * sizeof(in_formation[0]));
+    memset(live, 0, bodies->count * sizeof(live[0]));
+
+    for (int n = 0; n < divers->count; n++){
+
+        d = BODY(divers->dense[n]);
+        diving[d] = live[d] = 1;
+    }
+
+    for (int n = 0; n < formation->count; n++){
+
+        d = BODY(formation->dense[n]);
+        in_formation[d] = live[d] = 1;
+    }
+
+    simd_integrate(body->pos_x, body->pos_y, body->sub_x, body->sub_y,
+                   body->velo_x, body->velo_y, diving, bodies->count);
+    /* The formation can fall a few ticks behind when time is short;
+       the divers never do */
+    formation_lag += enemy_wiggle;
+
+    if (detail < GAME_DETAIL_LOW || round_time % FORMATION_EVERY == 0){
+
+        simd_shift_x(body->pos_x, formation_lag, in_formation, bodies->count);
+        formation_lag = 0;
+    }
+
+    behaviour_update(w, e, detail >= GAME_DETAIL_REDUCED ? round_time & 1 : -1);
+
+    /* From the end, since the ones that get home leave the set */
+    for (int n = divers->count; n-- > 0;){
+
+        i = divers->dense[n];
+
+        enemy_return(i);
+
+        if (!HAS(i, C_DIVING))
+            formation_join(i);
+
+        else
+            enemy_shoot(i);
+    }
+
+    ship_colision(live);
+
+    return divers->count + formation->count;
+}
+
+void move_enemy_bul(){
+
+    const ecs_world *w = &game_state.ecs;
+    bullet_store *b = &game_state.bullets;
+    unsigned char hits[HIT_MASK_BYTES(MAX_BULLETS)];
+    int s = BODY(ECS_SHIP);
+
+    pattern_update(&game_state);
+
+    simd_integrate(b->pos_x, b->pos_y, b->sub_x, b->sub_y, b->velo_x, b->velo_y, b->active, MAX_BULLETS);
+    simd_hit_mask(b->pos_x, b->pos_y, b->active, MAX_BULLETS,
+                  w->body.pos_x[s], w->body.pos_y[s], SHIP_WIDTH, SHIP_HEIGHT, hits);
+
+    /* Walk the live bullets from the end so releasing is safe */
+    for (int n = b->slots.count; n-- > 0;){
+
+        int k = b->slots.live[n];
+
+        if (HAS(ECS_SHIP, C_ACTIVE) && !game_state.ship.explosion_timer && HIT(hits, k)){
+
+            release_enemy_bul(k);
+
+            change_score(SHIP);
+
+            ship_hit();
+
+            continue;
+        }
+
+        /* Patterns fire every way, so off any edge */
+        if ((unsigned short) b->pos_y[k] >= SCREEN_HEIGHT ||
+            (unsigned short) b->pos_x[k] >= SCREEN_WIDTH)
+            release_enemy_bul(k);
+    } 
+}
+
+
+
+/* Ship bullet k (entity ECS_SHIP_BULLET + k) against the enemies */
+void bullet_colision(int k){
+
+    ecs_world *w = &game_state.ecs;
+    body_data *body = &w->body;
+    int b = ECS_SHIP_BULLET + k, i;
+
+    if (!HAS(b, C_SHOT)) return;
+
+    if ((i = find_enemy_hit(body->pos_x[BODY(b)], body->pos_y[BODY(b)], ENEMY_WIDTH, ENEMY_HEIGHT)) == -1)
+        return;
+
+    formation_leave(i);
+
+    change_active_amount(body->sprite[BODY(i)]);
+
+    ecs_retire(w, b);
+
+    if (++ kill_count >= 15 && !HAS(ECS_POWERUP, C_ACTIVE) &&
+        HAS(ECS_SHIP, C_ACTIVE) && !game_state.ship.explosion_timer) 
+            drop_powerup(i);
+
+    change_score(body->sprite[BODY(i)]);
+
+    enemy_explode(i);
+}
+
+void bullet_movement(int new_bullet){
+
+    ecs_world *w = &game_state.ecs;
+    body_data *body = &w->body;
+    const ecs_set *shots = ecs_members(w, C_SHOT);
+    int b, d, k;
+
+    build_enemy_grid();
+
+    /* From the end, since the ones that land or leave drop out of the set */
+    for (int n = shots->count; n-- > 0;) {
+
+        b = shots->dense[n];
+        d = BODY(b);
+
+        body->pos_y[d] += FIX_INT(body->velo_y[d]);
+
+        if (body->pos_y[d] <= 5){
+
+            ecs_retire(w, b);
+            continue;
+        }
+
+        bullet_colision(b - ECS_SHIP_BULLET);
+    }
+
+    if (new_bullet && shots->count < game_state.ship.num_buls) {
+
+        /* The lowest free one; num_buls is never over SHIP_BULLETS */
+        for (k = 0; HAS(ECS_SHIP_BULLET + k, C_SHOT); k++);
+
+        b = ECS_SHIP_BULLET + k;
+        ecs_add(w, b, C_BODY | C_ACTIVE | C_SHOT);
+        d = BODY(b);
+
+        body->pos_x[d] = body->pos_x[BODY(ECS_SHIP)];
+        body->pos_y[d] = body->pos_y[BODY(ECS_SHIP)]-(SHIP_HEIGHT);
+        body->velo_y[d] = FIX(-3);
+        body->sprite[d] = SHIP_BULLET;
+    }
+}
+
+
+
+void ship_movement(){
+
+    body_data *body = &game_state.ecs.body;
+    int s = BODY(ECS_SHIP);
+    short vx = FIX_INT(body->velo_x[s]), vy = FIX_INT(body->velo_y[s]);
+
+    if(vx > 0 && body->pos_x[s] < SCREEN_WIDTH-SHIP_WIDTH-5)
+        body->pos_x[s] += vx;
+
+    else if(vx < 0 && body->pos_x[s] > 5)
+        body->pos_x[s] += vx;
+
+
+    if (vy > 0 && body->pos_y[s] < SCREEN_HEIGHT-SHIP_HEIGHT*2-5)
+        body->pos_y[s] += vy;
+
+    else if (vy < 0 && body->pos_y[s] > 5)
+        body->pos_y[s] += vy;
+    
+}
+
+// taking too long to move
+// after so long I can have liek 5 go at the same time just remove %
+int enemies_to_move(){
+
+    enemy *enemy;
+    int rand_enemy;
+
+
+    if (TOTAL_ACTIVE != 0){
+        
+        rand_enemy = rand() % TOTAL_ACTIVE;
+
+        if (rand_enemy < active1)
+            rand_enemy = ENEMY1;
+        
+        else if (rand_enemy < active1 + active2)
+            rand_enemy =  ENEMY2;
+        
+        else 
+            rand_enemy = ENEMY3;
+
+        if (num_sent == send_per_round){
+
+            if (!ecs_members(&game_state.ecs, C_DIVING)->count){
+
+                num_sent = 0;
+                round_pause = ROUND_WAIT/2;
+            }
+        }
+        else if (num_sent > send_per_round/4 && num_sent <= send_per_round/4 +3){
+
+            num_sent ++;
+            return rand_enemy;
+        }
+        else if (num_sent > send_per_round*3/4 && num_sent <= send_per_round*3/4 +3){
+
+            num_sent ++;
+            return rand_enemy;
+        }
+        else{
+
+            if(round_time % waves->rounds[round_num - 1].every == 0) {
+
+                num_sent ++;
+                return rand_enemy;
+            }
+
+            else return -1;
+        }
+    }
+
+    return -1;
+
+}
+
+void init_round_state() {
+
+    ecs_world *w = &game_state.ecs;
+    enemy_store *e = &game_state.enemies;
+    wave_formation f = wave_formation_of(waves, round_num - 1);
+    int n = f.count, type, d;
+    bool claimed[MAX_ROWS] = { false };
+
+    memset(row_mask, 0, sizeof(row_mask));
+    memset(row_slot, 0xff, sizeof(row_slot));
+    memset(launch_count, 0, sizeof(launch_count));
+    formation_lag = 0;
+
+    pattern_init(&game_state.emitters);
+
+    /* Last first: the enemies' bodies sit in the order they were added,
+       so each one retired is then at the end of the set with nothing to
+       move into its place */
+    for (int i = ENEMY_COUNT; i-- > 0;)
+        clear_enemy(i);
+
+    /* The file keeps a formation the way enemy_store does */
+    memcpy(e->start_x, f.x, n * sizeof(e->start_x[0]));
+    memcpy(e->start_y, f.y, n * sizeof(e->start_y[0]));
+    memcpy(e->row, f.row, n);
+    memcpy(e->col, f.col, n);
+    memcpy(e->path, f.path, n);
+
+    for (int i = 0; i < n; i++){
+
+        /* On the field, but off screen until its column comes on */
+        ecs_add(w, i, C_BODY);
+        d = BODY(i);
+
+        w->body.pos_x[d] = f.x[i];
+        w->body.pos_y[d] = f.y[i];
+        w->body.sprite[d] = f.sprite[i];
+
+        /* A row's first enemy decides whose row it is */
+        if (!claimed[f.row[i]]){
+
+            claimed[f.row[i]] = true;
+            type = f.sprite[i] - ENEMY1;
+            launch_rows[type][launch_count[type]++] = f.row[i];
+        }
+
+        row_slot[f.row[i]][f.col[i]] = i;
+
+        switch(f.sprite[i]){
+
+            case ENEMY1:
+                active1 ++;
+                break;
+
+            case ENEMY2:
+                active2 ++;
+                break;
+
+            case ENEMY3:
+                active3 ++;
+                break;
+        }
+    }
+
+    for (int i = n; i < ENEMY_COUNT; i++)
+        e->col[i] = -1;
+}
+
+
+
+
+// static int x_coords[40] = {
+//     // Y
+//     50, 66, 82, 66, 66,
+//     // O
+//     134, 150, 166, 134, 166, 134, 150, 166,
+//     // U
+//     182, 198, 214, 182, 214, 182, 198, 214,
+//     // W
+//     246, 262, 278, 294, 262,
+//     // I
+//     310, 326, 342, 326, 326,
+//     // N
+//     358, 358, 374, 390, 390,
+//     // !
+//     406, 406, 406, 406
+// };
+
+// static int y_coords[40] = {
+//     // Y
+//     50, 50, 50, 66, 82,
+//     // O
+//     50, 50, 50, 66, 66, 82, 82, 82,
+//     // U
+//     50, 50, 50, 66, 66, 82, 82, 82,
+//     // W
+//     50, 50, 50, 50, 66,
+//     // I
+//     50, 50, 50, 66, 82,
+//     // N
+//     50, 66, 66, 82, 50,
+//     // !
+//     50, 66, 82, 114
+// };
+
+
+
+
+
+
+/*
+ * Apply one report from the pad to the ship.  Returns 1 when the report
+ * is a fresh press of a fire button.
+ */
+int handle_input(const controller_packet *packet){
+
+    body_data *body = &game_state.ecs.body;
+    int s = BODY(ECS_SHIP), new_bullet = 0;
+
+    switch (packet->lr_arrows) {
+        case LEFT_ARROW:
+            if(body->pos_x[s] > 0)
+                body->velo_x[s] = FIX(-ship_velo);
+
+            // printf("%d, %d \n", ship->pos_x, ship->pos_y);
+            break;
+            
+        case RIGHT_ARROW:
+            if(body->pos_x[s] < SCREEN_WIDTH-SHIP_WIDTH)
+                body->velo_x[s] = FIX(ship_velo);
+
+            // printf("%d, %d \n", ship->pos_x, ship->pos_y);
+            break;
+
+        default:
+            body->velo_x[s] = 0;
+            break;
+    }
+
+    switch (packet->ud_arrows) {
+        case UP_ARROW:
+            if (body->pos_y[s] < SCREEN_HEIGHT - 5)
+                body->velo_y[s] = FIX(-ship_velo);
+
+            // printf("%d, %d\n", ship->pos_x, ship->pos_y);
+            break;
+            
+        case DOWN_ARROW:
+            if (body->pos_y[s] > 0+SHIP_HEIGHT)
+                body->velo_y[s] = FIX(ship_velo);
+
+            // printf("%d, %d \n", ship->pos_x, ship->pos_y);
+            break;
+
+        default:
+            body->velo_y[s] = 0;
+            break;
+    }
+
+    switch (packet->buttons) {                
+        case Y_BUTTON:
+            if (!prev_bullet ){
+                new_bullet = 1; // do not allow them to hold the button to shoot
+                prev_bullet = 1;
+            }
+
+            buttons = 1;
+            // printf("Bullet \n");
+            break;
+
+        default:
+            if (!bumpers) prev_bullet = 0;
+            buttons = 0;
+            break;
+    }
+
+    switch (packet->bumpers) {
+        case LEFT_BUMPER:
+            if (!prev_bullet){
+                new_bullet = 1; // do not allow them to hold the button to shoot
+                prev_bullet = 1;
+            }
+
+            bumpers = 1;
+
+            break;
+            
+        case RIGHT_BUMPER:
+            if (!prev_bullet){
+                new_bullet = 1; // do not allow them to hold the button to shoot
+                prev_bullet = 1;
+            }
+
+            bumpers = 1;
+
+            break;
+
+        case LR_BUMPER:
+            if (!prev_bullet ){
+                new_bullet = 1; // do not allow them to hold the button to shoot
+                prev_bullet = 1;
+            }
+            bumpers = 1;
+            break;
+
+        default:
+            if (!buttons) prev_bullet = 0; // only reset bullets if the y button has not been pressed
+            bumpers = 0;
+            // printf("bumpers\n");
+            break;
+    }
+
+    return new_bullet;
+}
+
+
+/*
+ * Advance the simulation by one tick.  Input has already been applied
+ * to the ship; new_bullet is set when a fire button was just pressed.
+ */
+int game_step(int new_bullet){
+
+    ecs_world *w = &game_state.ecs;
+    ship_state *ship = &game_state.ship;
+    int rand_enemy, save_score;
+
+    round_time++;
+
+    enemy_wiggle_time += enemy_wiggle;
+    if (abs(enemy_wiggle_time) == 80) enemy_wiggle = -enemy_wiggle;
+
+    if (ship->lives == 0) return GAME_LOST;
+
+    if(HAS(ECS_SHIP, C_ACTIVE) && !ship->explosion_timer) ship_movement();
+
+    move_powerup();
+    wheel_advance(&game_state.timers, fire_timer);
+
+    if (round_phase == ROUND_PLAYING){ // ship is alive and round is playing
+
+        TRACE2_BEGIN(ship_buls);
+        if(HAS(ECS_SHIP, C_ACTIVE)) bullet_movement(new_bullet); 
+        TRACE2_END(TRACE_SHIP_BULLETS, ship_buls);
+
+        TRACE2_BEGIN(ai);
+        rand_enemy = enemies_to_move();
+        enemies_remaining = enemy_movement(rand_enemy);
+        TRACE2_END(TRACE_AI, ai);
+
+        TRACE2_BEGIN(enemy_buls);
+        move_enemy_bul();
+        TRACE2_END(TRACE_ENEMY_BULLETS, enemy_buls);
+
+    }
+
+    else if(round_phase == ROUND_STARTING){
+
+        if(!HAS(ECS_SHIP, C_ACTIVE)){
+
+            ecs_add(w, ECS_SHIP, C_ACTIVE);
+            w->body.pos_x[BODY(ECS_SHIP)] = SHIP_INITIAL_X;
+            w->body.pos_y[BODY(ECS_SHIP)] = SHIP_INITIAL_Y;
+            round_phase = ROUND_PLAYING;
+            round_time = 0;
+
+            num_sent = 0;
+
+            powerup_over();
+            kill_count /= 2;
+        } 
+
+        else{
+
+            activate_column(col_active);
+
+            if (++col_active == waves->header->columns) round_phase = ROUND_PLAYING;
+        }
+    }
+
+    else{
+
+        ecs_remove(w, ECS_POWERUP, C_ACTIVE);
+
+        if(round_phase == ROUND_SETTLED && !ecs_members(w, C_SHOT)->count &&
+           !game_state.bullets.slots.count && !ecs_members(w, C_DIVING)->count)
+            round_phase = ROUND_STARTING;
+
+        TRACE2_BEGIN(ai);
+        enemy_movement(-1);
+        TRACE2_END(TRACE_AI, ai);
+
+        TRACE2_BEGIN(enemy_buls);
+        move_enemy_bul();
+        TRACE2_END(TRACE_ENEMY_BULLETS, enemy_buls);
+
+        TRACE2_BEGIN(ship_buls);
+        bullet_movement(0);
+        TRACE2_END(TRACE_SHIP_BULLETS, ship_buls);
+
+    }
+
+    if(ship->lives <= 0){
+        printf("You lost =( \n");
+
+        save_score = game_state.score;
+
+        memset(&game_state, 0, sizeof(game_state));
+
+        game_state.score = save_score;
+
+        return GAME_LOST;
+    }
+
+    if(!enemies_remaining){
+
+        if(round_num == waves->header->rounds){
+
+            printf("You Won!");
+
+            memset(&game_state, 0, sizeof(game_state));
+
+            return GAME_WON;
+        }
+
+        if(!game_state.bullets.slots.count){
+
+            enemy_wiggle_time = 0;
+            enemy_wiggle = 1;
+
+            round_wait();
+            col_active = 0;
+
+            round_time = 0;
+            num_sent = 0;
+
+            send_per_round += send_per_round/4;
+
+            active1 = active2 = active3 = 0;
+
+            round_num++;
+            init_round_state();
+
+            enemies_remaining = 1;
+        }
+
+    }
+
+    return GAME_RUNNING;
+}
+
+
+void game_set_detail(int level) {
+
+    detail = level;
+}
+
+
+game_world *game_world_state() {
+
+    return &game_state;
+}
+
+
+/* Start a game: the ship in play, no bullets and the first round's
+   formation, with no enemies on screen yet */
+void game_init(const wave_file *w) {
+
+    body_data *body = &game_state.ecs.body;
+
+    waves = w;
+    behaviour_load(w);
+
+    pool_init(&game_state.bullets.slots, MAX_BULLETS);
+    wheel_init(&game_state.timers, GAME_TIMERS);
+
+    ecs_add(&game_state.ecs, ECS_SHIP, C_BODY | C_ACTIVE);
+    body->pos_x[BODY(ECS_SHIP)] = SHIP_INITIAL_X;
+    body->pos_y[BODY(ECS_SHIP)] = SHIP_INITIAL_Y;
+    body->sprite[BODY(ECS_SHIP)] = SHIP;
+
+    /* Hidden until an enemy drops it */
+    ecs_add(&game_state.ecs, ECS_POWERUP, C_BODY);
+
+    init_round_state();
+}
@@ -0,0 +1,79 @@
+#ifndef _GAME_H
+#define _GAME_H
+
+#include "vga_ball.h"
+#include "input.h"
+#include "entities.h"
+#include "wave.h"
+
+/* Countdowns on game_world.timers: two per enemy, the ship's, the
+   power-up's two and the round's */
+#define GAME_TIMERS (2 * ENEMY_COUNT + 4)
+
+/* Results of one simulation tick */
+#define GAME_RUNNING 0
+#define GAME_LOST 1
+#define GAME_WON 2
+
+/* Set up the first round of waves, which must stay mapped for the
+   whole game.  Enemies stay off screen until their column is
+   activated. */
+extern void game_init(const wave_file *waves);
+
+/* Bring every enemy in one formation column (of the wave file's
+   columns) on screen */
+extern void activate_column(int col);
+
+/* Apply one report from the pad to the ship.  Returns 1 when the report
+   is a fresh press of a fire button. */
+extern int handle_input(const controller_packet *);
+
+/* Run one simulation tick.  new_bullet fires a ship bullet if one is
+   free.  Returns GAME_RUNNING, GAME_LOST or GAME_WON. */
+extern int game_step(int new_bullet);
+
+/*
+ * Levels of detail, for when ticks run over budget.  Diving enemies
+ * and collisions always run every tick.
+ *
+ *     GAME_DETAIL_REDUCED  homing enemies re-aim every other tick
+ *     GAME_DETAIL_LOW      ... and the formation moves every 4th tick
+ */
+#define GAME_DETAIL_FULL 0
+#define GAME_DETAIL_REDUCED 1
+#define GAME_DETAIL_LOW 2
+
+/* Run the ticks that follow at a GAME_DETAIL_* level */
+extern void game_set_detail(int level);
+
+/* Pack the current state into the words UPDATE_FRAME writes */
+extern void game_pack(frame_words *);
+
+/* Hash of the simulation state, for checking that a replay matches
+   the run it was recorded from */
+extern unsigned int game_checksum(void);
+
+/*
+ * Pieces of a tick, for bench.c to drive one at a time
+ */
+
+/* The live game state */
+extern game_world *game_world_state(void);
+
+/* Lay out the current round's formation */
+extern void init_round_state(void);
+
+/* Rebuild the broadphase grid bullet_colision() queries */
+extern void build_enemy_grid(void);
+
+/* Launch rand_enemy's row end (-1 for none), move every enemy and
+   check them against the ship.  Returns the enemies left. */
+extern int enemy_movement(int rand_enemy);
+
+/* Move the enemy bullets and check them against the ship */
+extern void move_enemy_bul(void);
+
+/* Ship bullet k against the enemies */
+extern void bullet_colision(int k);
+
+#endif
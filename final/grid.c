@@ -0,0 +1,48 @@
+#include "grid.h"
+
+#include <string.h>
+
+static int grid_col(int x){
+
+    if (x < 0) return 0;
+    if (x >= SCREEN_WIDTH) return GRID_COLS - 1;
+    return x / GRID_CELL;
+}
+
+static int grid_row(int y){
+
+    if (y < 0) return 0;
+    if (y >= SCREEN_HEIGHT) return GRID_ROWS - 1;
+    return y / GRID_CELL;
+}
+
+void grid_clear(grid *g){
+
+    memset(g->head, 0xff, sizeof(g->head));
+}
+
+void grid_insert(grid *g, int id, int x, int y){
+
+    int cell = grid_row(y) * GRID_COLS + grid_col(x);
+
+    g->next[id] = g->head[cell];
+    g->head[cell] = id;
+}
+
+int grid_query(const grid *g, int x, int y, int half_w, int half_h,
+               short *out, int max){
+
+    int col_lo = grid_col(x - half_w), col_hi = grid_col(x + half_w);
+    int row_lo = grid_row(y - half_h), row_hi = grid_row(y + half_h);
+    int found = 0;
+
+    for (int row = row_lo; row <= row_hi; row++)
+        for (int col = col_lo; col <= col_hi; col++)
+            for (int id = g->head[row * GRID_COLS + col]; id != -1; id = g->next[id]){
+
+                if (found == max) return found;
+                out[found++] = id;
+            }
+
+    return found;
+}
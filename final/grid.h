@@ -0,0 +1,39 @@
+#ifndef _GRID_H
+#define _GRID_H
+
+#include "vga_ball.h"
+
+/* Cell size in pixels.  Must be at least twice the largest half-extent
+   queried so a query never spans more than 2x2 cells. */
+#define GRID_CELL 32
+#define GRID_COLS (SCREEN_WIDTH / GRID_CELL)
+#define GRID_ROWS (SCREEN_HEIGHT / GRID_CELL)
+
+/* Most entries one grid can hold */
+#define GRID_CAPACITY ENEMY_COUNT
+
+/*
+ * Uniform grid over the 640x480 playfield for broadphase collision.
+ * Each cell is a singly linked list threaded through next[], so
+ * rebuilding is a clear plus one insert per entity and a query only
+ * walks the cells its box touches.  Positions off the playfield are
+ * clamped into the border cells.
+ */
+typedef struct {
+    short head[GRID_ROWS * GRID_COLS];  /* first id in each cell, -1 if empty */
+    short next[GRID_CAPACITY];          /* next id in the same cell, -1 at the end */
+} grid;
+
+/* Empty every cell */
+extern void grid_clear(grid *);
+
+/* Add id (0 .. GRID_CAPACITY-1) at x, y */
+extern void grid_insert(grid *, int id, int x, int y);
+
+/* Store up to max ids whose cell overlaps the box x +/- half_w,
+   y +/- half_h into out.  Returns how many were stored.  Callers still
+   do the exact overlap test. */
+extern int grid_query(const grid *, int x, int y, int half_w, int half_h,
+                      short *out, int max);
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef _INPUT_H
+#define _INPUT_H
+
+#include <stdint.h>
+
+/* One report from the gamepad */
+typedef struct {
+    uint8_t pad_1;
+    uint8_t pad_2;
+    uint8_t pad_3;
+    uint8_t lr_arrows;
+    uint8_t ud_arrows;
+    uint8_t buttons;
+    uint8_t bumpers; // maybe change name
+    uint8_t pad_4;
+
+} controller_packet;
+
+#define LEFT_ARROW 0x00
+#define RIGHT_ARROW 0xff
+#define UP_ARROW 0x00
+#define DOWN_ARROW 0xff
+#define BUTTON_A 0x2f
+#define Y_BUTTON 0x8f
+#define LEFT_BUMPER 0x01
+#define RIGHT_BUMPER 0x02
+#define LR_BUMPER 0x03
+
+#define NO_INPUT 0x7f // ??????????????????
+
+#endif
@@ -0,0 +1,200 @@
+#include "pattern.h"
+#include "pool.h"
+#include "fixed.h"
+#include "ecs.h"
+
+/* Ops one emitter may run in a tick, so a script missing a WAIT in a
+   loop stalls instead of hanging the game */
+#define PATTERN_STEPS 32
+
+#define SPEED(v)        { PAT_SPEED, 0, FIX(v) }
+#define HEADING(a)      { PAT_HEADING, 0, (a) }
+#define AIM(a)          { PAT_AIM, 0, (a) }
+#define TURN(a)         { PAT_TURN, 0, (fix_angle) (a) }
+#define FIRE(n, spread) { PAT_FIRE, (n), (spread) }
+#define WAIT(t)         { PAT_WAIT, 0, (t) }
+#define LOOP(n, to)     { PAT_LOOP, (n), (to) }
+#define END             { PAT_END, 0, 0 }
+
+/* ENEMY2's shot */
+static const pattern_op drop[] = {
+    SPEED(3), HEADING(FIX_QUARTER), FIRE(1, 0), END,
+};
+
+static const pattern_op aimed[] = {
+    SPEED(4), AIM(0), FIRE(1, 0), END,
+};
+
+/* ENEMY3's shot: six of the board's fifteen bullets at most */
+static const pattern_op fan[] = {
+    SPEED(3),
+    AIM(0), FIRE(3, FIX_TURN(15)), WAIT(12), LOOP(2, 1),
+    END,
+};
+
+static const pattern_op radial[] = {
+    SPEED(2), HEADING(0),
+    FIRE(16, 65536 / 16), WAIT(20), TURN(65536 / 32), LOOP(2, 2),
+    END,
+};
+
+static const pattern_op spiral[] = {
+    SPEED(2), HEADING(0),
+    FIRE(4, FIX_QUARTER), TURN(FIX_TURN(11)), WAIT(4), LOOP(30, 2),
+    END,
+};
+
+const pattern_op *const pattern_scripts[PATTERNS] = {
+    [PATTERN_DROP] = drop,
+    [PATTERN_AIMED] = aimed,
+    [PATTERN_FAN] = fan,
+    [PATTERN_RADIAL] = radial,
+    [PATTERN_SPIRAL] = spiral,
+};
+
+
+void pattern_init(emitter_store *em) {
+
+    pool_init(&em->slots, MAX_EMITTERS);
+}
+
+pool_handle pattern_start(game_world *w, int script, int owner, int dx, int dy) {
+
+    emitter_store *em = &w->emitters;
+    int s;
+
+    if (owner >= 0 && pool_slot(&em->slots, w->enemies.emitter[owner]) != -1)
+        return POOL_NONE;
+
+    if ((s = pool_acquire(&em->slots)) == -1) return POOL_NONE;
+
+    em->x[s] = dx;
+    em->y[s] = dy;
+    em->owner[s] = owner >= 0 ? ecs_handle(&w->ecs, owner) : POOL_NONE;
+    em->heading[s] = 0;
+    em->speed[s] = 0;
+    em->wait[s] = 0;
+    em->script[s] = script;
+    em->pc[s] = em->loops[s] = 0;
+
+    if (owner >= 0) w->enemies.emitter[owner] = pool_handle_of(&em->slots, s);
+
+    return pool_handle_of(&em->slots, s);
+}
+
+/*
+ * One volley of n bullets from x, y, spread apart and centred on
+ * heading.  The slots are taken up front so the velocities are worked
+ * out in one pass over them; a short pool just makes a thinner volley.
+ */
+static void fire(game_world *w, int owner, int x, int y,
+                 fix_angle heading, fix_angle spread, int speed, int n) {
+
+    bullet_store *b = &w->bullets;
+    short slots[MAX_BULLETS];
+    fix_angle a = heading - (fix_angle) (spread * (n - 1) / 2);
+    int got = 0, k;
+
+    while (got < n && got < MAX_BULLETS && (k = pool_acquire(&b->slots)) != -1)
+        slots[got++] = k;
+
+    for (int j = 0; j < got; j++, a += spread) {
+
+        k = slots[j];
+
+        b->active[k] = 1;
+        b->pos_x[k] = x;
+        b->pos_y[k] = y;
+        b->sub_x[k] = b->sub_y[k] = 0;
+
+        fix_polar(a, speed, &b->velo_x[k], &b->velo_y[k]);
+    }
+
+    /* The owner holds its newest bullet, which is what keeps it from
+       firing again while that bullet is in flight */
+    if (got && owner >= 0)
+        w->enemies.bul[owner] = pool_handle_of(&b->slots, slots[got - 1]);
+}
+
+/* Run emitter s up to its next WAIT.  Returns 0 once it has ended. */
+static int run(game_world *w, int s) {
+
+    emitter_store *em = &w->emitters;
+    const ecs_world *ecs = &w->ecs;
+    const pattern_op *script = pattern_scripts[em->script[s]];
+    int owner = ecs_entity(ecs, em->owner[s]), x = em->x[s], y = em->y[s];
+    int ship = ecs_body(ecs, ECS_SHIP);
+
+    if (em->owner[s] != POOL_NONE) {
+
+        /* Gone, or going */
+        if (owner == -1 || !ecs_has(ecs, owner, C_ACTIVE, C_EXPLODING)) return 0;
+
+        x += ecs->body.pos_x[ecs_body(ecs, owner)];
+        y += ecs->body.pos_y[ecs_body(ecs, owner)];
+    }
+
+    for (int steps = 0; steps < PATTERN_STEPS; steps++) {
+
+        const pattern_op *op = &script[em->pc[s]++];
+
+        switch (op->op) {
+
+            case PAT_END:
+                return 0;
+
+            case PAT_SPEED:
+                em->speed[s] = op->arg;
+                break;
+
+            case PAT_HEADING:
+                em->heading[s] = op->arg;
+                break;
+
+            case PAT_AIM:
+                em->heading[s] = fix_heading(ecs->body.pos_x[ship] - x, ecs->body.pos_y[ship] - y) + op->arg;
+                break;
+
+            case PAT_TURN:
+                em->heading[s] += op->arg;
+                break;
+
+            case PAT_FIRE:
+                /* Nothing to shoot at between lives */
+                if (ecs_has(ecs, ECS_SHIP, C_ACTIVE, 0))
+                    fire(w, owner, x, y, em->heading[s], op->arg, em->speed[s], op->count);
+                break;
+
+            case PAT_WAIT:
+                em->wait[s] = op->arg;
+                return 1;
+
+            case PAT_LOOP:
+                if (!em->loops[s]) em->loops[s] = op->count;
+                if (--em->loops[s]) em->pc[s] = op->arg;
+                break;
+        }
+    }
+
+    return 1;
+}
+
+void pattern_update(game_world *w) {
+
+    emitter_store *em = &w->emitters;
+
+    /* From the end of live[], since finished emitters are released */
+    for (int n = em->slots.count; n-- > 0;) {
+
+        int s = em->slots.live[n];
+
+        if (em->wait[s] > 1) {
+            em->wait[s]--;
+            continue;
+        }
+
+        em->wait[s] = 0;
+
+        if (!run(w, s)) pool_release(&em->slots, s);
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef _PATTERN_H
+#define _PATTERN_H
+
+#include "entities.h"
+
+/*
+ * Enemy bullet patterns as tiny scripts.
+ *
+ * An emitter runs a script a few ops a tick: set the speed and
+ * heading, aim at the ship, turn, fire a volley, wait, loop.  A volley
+ * of n bullets is spread evenly around the heading, so one FIRE op is
+ * an aimed shot, a fan or, with a spread of a full turn over n, a
+ * radial burst; turning between volleys makes a spiral.  Speeds and
+ * angles are the fixed point of fixed.h, so bullets leave on exactly
+ * the same paths on the board and the host.
+ *
+ * Volleys go into bullet_store like any enemy bullet, as many as the
+ * pool has room for, and the owner's bul handle tracks the last one.
+ * An enemy runs one pattern at a time: its emitter handle tracks it.
+ */
+enum {
+    PAT_END,        /* done; the emitter is freed */
+    PAT_SPEED,      /* arg: Q8.8 pixels per tick */
+    PAT_HEADING,    /* arg: absolute fix_angle */
+    PAT_AIM,        /* heading at the ship, plus arg */
+    PAT_TURN,       /* heading += arg */
+    PAT_FIRE,       /* count bullets, arg apart, centred on the heading */
+    PAT_WAIT,       /* resume arg ticks later */
+    PAT_LOOP,       /* back to op arg until the body has run count times */
+};
+
+typedef struct {
+    unsigned char op, count;
+    unsigned short arg;
+} pattern_op;
+
+/* The scripts, by number so emitters stay plain data */
+enum {
+    PATTERN_DROP,   /* one bullet straight down */
+    PATTERN_AIMED,  /* one bullet at the ship */
+    PATTERN_FAN,    /* two fans of three at the ship */
+    PATTERN_RADIAL, /* two rings of sixteen */
+    PATTERN_SPIRAL, /* four arms wound round for two seconds */
+    PATTERNS
+};
+
+extern const pattern_op *const pattern_scripts[PATTERNS];
+
+/* Empty the emitters */
+extern void pattern_init(emitter_store *);
+
+/* Start script firing from dx, dy off enemy owner's position, or from
+   dx, dy on screen with owner -1.  It runs from the next
+   pattern_update(); the emitter stops by itself when the script ends
+   or the owner dies.  Returns POOL_NONE if every emitter is busy or
+   the owner's last pattern is still running. */
+extern pool_handle pattern_start(game_world *, int script, int owner, int dx, int dy);
+
+/* Run every emitter for one tick.  Call it before the enemy bullets
+   move so a volley leaves on the tick it was fired, as single shots
+   always have. */
+extern void pattern_update(game_world *);
+
+#endif
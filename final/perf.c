@@ -0,0 +1,245 @@
+#include "perf.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+_Thread_local int perf_enabled = 0;
+
+static const struct {
+    uint32_t type;
+    uint64_t config;
+} events[PERF_COUNTERS] = {
+    [PERF_CYCLES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    [PERF_INSTRUCTIONS] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    [PERF_L1D_MISSES] = { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                          PERF_COUNT_HW_CACHE_OP_READ << 8 |
+                          PERF_COUNT_HW_CACHE_RESULT_MISS << 16 },
+    [PERF_BRANCH_MISSES] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+};
+
+/*
+ * A counting thread: one group led by its cycle counter, read with a
+ * single read().  slot[c] is counter c's place in the group, -1 if it
+ * did not open.  The totals are taken under lock because
+ * perf_report() reads every thread's from the game thread.
+ */
+typedef struct {
+    const char *name;
+    int fds[PERF_COUNTERS];
+    int slot[PERF_COUNTERS];
+    int group_size;
+
+    uint64_t stack[PERF_DEPTH][PERF_COUNTERS];
+    int depth;
+
+    pthread_mutex_t lock;
+    uint64_t totals[PERF_MAX_PHASES][PERF_COUNTERS];
+    unsigned long calls[PERF_MAX_PHASES];
+} perf_thread;
+
+/* Threads that have claimed a context, and whether any is counting */
+static perf_thread threads[PERF_THREADS];
+static int thread_count;
+static pthread_mutex_t threads_lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_int counting;
+
+static _Thread_local perf_thread *self;
+
+static int open_counter(const int *fds, int c, int exclude_kernel) {
+
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = events[c].type;
+    attr.config = events[c].config;
+    attr.disabled = fds[0] == -1;   /* the leader starts the group */
+    attr.exclude_kernel = exclude_kernel;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+
+    return syscall(__NR_perf_event_open, &attr, 0, -1, fds[0], 0);
+}
+
+int perf_open(const char *name) {
+
+    /* Count the driver's ioctl time too if we are allowed to */
+    int exclude_kernel = 0;
+    perf_thread *t;
+    int *fds;
+
+    if (self == NULL) {
+
+        pthread_mutex_lock(&threads_lock);
+
+        if (thread_count < PERF_THREADS) {
+            self = &threads[thread_count++];
+            pthread_mutex_init(&self->lock, NULL);
+        }
+
+        pthread_mutex_unlock(&threads_lock);
+
+        if (self == NULL) {
+            fprintf(stderr, "perf: more than %d threads\n", PERF_THREADS);
+            return -1;
+        }
+    }
+
+    t = self;
+    fds = t->fds;
+    t->name = name;
+
+    for (int c = 0; c < PERF_COUNTERS; c++) fds[c] = -1;
+
+    if ((fds[0] = open_counter(fds, PERF_CYCLES, 0)) == -1) {
+        exclude_kernel = 1;
+        fds[0] = open_counter(fds, PERF_CYCLES, 1);
+    }
+
+    if (fds[0] == -1) {
+        perror("perf_event_open");
+        return -1;
+    }
+
+    t->slot[PERF_CYCLES] = 0;
+    t->group_size = 1;
+
+    for (int c = 1; c < PERF_COUNTERS; c++) {
+
+        if ((fds[c] = open_counter(fds, c, exclude_kernel)) == -1) {
+            t->slot[c] = -1;
+            continue;
+        }
+
+        t->slot[c] = t->group_size++;
+    }
+
+    if (t->slot[PERF_INSTRUCTIONS] == -1) {
+        fprintf(stderr, "perf: no instruction counter\n");
+        perf_close();
+        return -1;
+    }
+
+    ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+    perf_enabled = 1;
+    atomic_store(&counting, 1);
+
+    return 0;
+}
+
+int perf_counting() {
+
+    return atomic_load(&counting);
+}
+
+static void read_counters(uint64_t *out) {
+
+    struct {
+        uint64_t nr;
+        uint64_t values[PERF_COUNTERS];
+    } group;
+
+    if (read(self->fds[0], &group, sizeof(group)) < 0) {
+        memset(out, 0, PERF_COUNTERS * sizeof(uint64_t));
+        return;
+    }
+
+    for (int c = 0; c < PERF_COUNTERS; c++)
+        out[c] = self->slot[c] == -1 ? 0 : group.values[self->slot[c]];
+}
+
+void perf_push() {
+
+    if (self->depth < PERF_DEPTH) read_counters(self->stack[self->depth]);
+
+    self->depth++;
+}
+
+void perf_pop(int phase) {
+
+    perf_thread *t = self;
+    uint64_t now[PERF_COUNTERS];
+
+    if (--t->depth >= PERF_DEPTH || phase >= PERF_MAX_PHASES) return;
+
+    read_counters(now);
+
+    pthread_mutex_lock(&t->lock);
+
+    for (int c = 0; c < PERF_COUNTERS; c++)
+        t->totals[phase][c] += now[c] - t->stack[t->depth][c];
+
+    t->calls[phase]++;
+
+    pthread_mutex_unlock(&t->lock);
+}
+
+/* Print counter c per thousand instructions, or n/a if it is missing */
+static void print_per_kilo(const perf_thread *t, const uint64_t *total, int c) {
+
+    if (t->slot[c] == -1 || !total[PERF_INSTRUCTIONS]) printf(" %12s", "n/a");
+
+    else printf(" %12.2f", 1000.0 * total[c] / total[PERF_INSTRUCTIONS]);
+}
+
+void perf_report(const char *const names[], int phases, unsigned long ticks) {
+
+    int n;
+
+    if (!perf_enabled) return;
+
+    pthread_mutex_lock(&threads_lock);
+    n = thread_count;
+    pthread_mutex_unlock(&threads_lock);
+
+    printf("perf over %lu ticks:\n", ticks);
+    printf("  %-8s %-14s %8s %12s %6s %12s %12s\n",
+           "thread", "phase", "calls", "cycles/call", "ipc", "l1d_miss/ki", "br_miss/ki");
+
+    for (int k = 0; k < n; k++) {
+
+        perf_thread *t = &threads[k];
+
+        pthread_mutex_lock(&t->lock);
+
+        for (int p = 0; p < phases && p < PERF_MAX_PHASES; p++) {
+
+            uint64_t *total = t->totals[p];
+
+            if (!t->calls[p]) continue;
+
+            printf("  %-8s %-14s %8lu %12.0f %6.2f", t->name, names[p], t->calls[p],
+                   (double) total[PERF_CYCLES] / t->calls[p],
+                   total[PERF_CYCLES] ? (double) total[PERF_INSTRUCTIONS] / total[PERF_CYCLES] : 0.0);
+
+            print_per_kilo(t, total, PERF_L1D_MISSES);
+            print_per_kilo(t, total, PERF_BRANCH_MISSES);
+            printf("\n");
+        }
+
+        memset(t->totals, 0, sizeof(t->totals));
+        memset(t->calls, 0, sizeof(t->calls));
+
+        pthread_mutex_unlock(&t->lock);
+    }
+}
+
+void perf_close() {
+
+    if (self == NULL) return;
+
+    for (int c = 0; c < PERF_COUNTERS; c++) {
+        if (self->fds[c] != -1) close(self->fds[c]);
+        self->fds[c] = -1;
+    }
+
+    perf_enabled = 0;
+}
@@ -0,0 +1,57 @@
+#ifndef _PERF_H
+#define _PERF_H
+
+#include <stdint.h>
+
+/*
+ * Hardware counters around the traced phases, through
+ * perf_event_open(2).  Off unless perf_open() succeeds; after that
+ * every TRACE_BEGIN/TRACE_END pair (see trace.h) also charges the
+ * counts it spans to its phase, and perf_report() prints IPC and miss
+ * rates per phase.
+ *
+ * Counters only see the thread that opened them, so each thread that
+ * wants counting calls perf_open() itself and gets its own group and
+ * totals.  The commit thread (see commit.h) does when the game thread
+ * has, which is where the commit ioctl is counted on the board.
+ */
+enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,        /* L1 data cache read misses */
+    PERF_BRANCH_MISSES,
+    PERF_COUNTERS
+};
+
+/* Most phases counted, how deeply phases may nest, and most threads
+   counted */
+#define PERF_MAX_PHASES 16
+#define PERF_DEPTH 4
+#define PERF_THREADS 4
+
+/* Whether this thread's counters are open */
+extern _Thread_local int perf_enabled;
+
+/* Open and start the counters for this thread, reported under name.
+   Returns 0 if at least cycles and instructions could be counted, -1
+   otherwise. */
+extern int perf_open(const char *name);
+
+/* Whether any thread has opened counters */
+extern int perf_counting(void);
+
+/* A phase starts: remember the counters */
+extern void perf_push(void);
+
+/* The innermost phase ends: charge what it counted to phase */
+extern void perf_pop(int phase);
+
+/* Print per-thread, per-phase IPC and misses per thousand
+   instructions for what was counted since the last report over ticks
+   simulation ticks, then start over */
+extern void perf_report(const char *const names[], int phases, unsigned long ticks);
+
+/* Close this thread's counters; what they counted is still reported */
+extern void perf_close(void);
+
+#endif
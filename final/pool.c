@@ -0,0 +1,71 @@
+#include "pool.h"
+
+#define HANDLE_SLOT(h) ((h) & 0xffff)
+#define HANDLE_GEN(h) ((h) >> 16)
+
+void pool_init(pool *p, int capacity){
+
+    if (capacity > POOL_CAPACITY) capacity = POOL_CAPACITY;
+
+    p->capacity = capacity;
+    p->count = 0;
+    p->free_count = capacity;
+
+    /* Stack top is the last entry, so slot 0 comes out first */
+    for (int i = 0; i < capacity; i++){
+
+        p->free_slots[i] = capacity - 1 - i;
+        p->live_pos[i] = -1;
+        p->gen[i] = 1;
+    }
+}
+
+int pool_acquire(pool *p){
+
+    int slot;
+
+    if (!p->free_count) return -1;
+
+    slot = p->free_slots[--p->free_count];
+
+    p->live_pos[slot] = p->count;
+    p->live[p->count++] = slot;
+
+    return slot;
+}
+
+void pool_release(pool *p, int slot){
+
+    int pos = p->live_pos[slot], last;
+
+    if (pos == -1) return;
+
+    /* Fill the hole with the last live slot */
+    last = p->live[--p->count];
+    p->live[pos] = last;
+    p->live_pos[last] = pos;
+
+    p->live_pos[slot] = -1;
+    p->gen[slot] = p->gen[slot] % 0x7fff + 1;
+    p->free_slots[p->free_count++] = slot;
+}
+
+pool_handle pool_handle_of(const pool *p, int slot){
+
+    return (p->gen[slot] << 16) | slot;
+}
+
+int pool_slot(const pool *p, pool_handle h){
+
+    int slot;
+
+    if (h < 0) return -1;
+
+    slot = HANDLE_SLOT(h);
+
+    if (slot >= p->capacity || p->live_pos[slot] == -1 ||
+        p->gen[slot] != HANDLE_GEN(h))
+        return -1;
+
+    return slot;
+}
@@ -0,0 +1,49 @@
+#ifndef _POOL_H
+#define _POOL_H
+
+/* Most slots one pool can hold */
+#ifndef POOL_CAPACITY
+#define POOL_CAPACITY 256
+#endif
+
+/* Handle that never resolves */
+#define POOL_NONE (-1)
+
+/*
+ * Fixed-capacity slot allocator.  Free slots sit on a stack and live
+ * slots in a dense list, so acquire and release are O(1) and loops walk
+ * only the live slots.  Releasing swaps the last live slot into the
+ * hole, so loops that may release should walk live[] from the end:
+ *
+ *     for (n = p->count; n-- > 0;) { slot = p->live[n]; ... }
+ *
+ * A handle is a slot plus the slot's generation.  Every release bumps
+ * the generation, so a handle kept past its slot's release stops
+ * resolving instead of pointing at whatever reused the slot.
+ */
+typedef int pool_handle;
+
+typedef struct {
+    short capacity, count, free_count;
+    short free_slots[POOL_CAPACITY];    /* stack of free slots */
+    short live[POOL_CAPACITY];          /* dense list of live slots */
+    short live_pos[POOL_CAPACITY];      /* index of each slot in live[], -1 if free */
+    unsigned short gen[POOL_CAPACITY];  /* 1 .. 0x7fff, so handles stay positive */
+} pool;
+
+/* Empty the pool and give it slots 0 .. capacity-1 */
+extern void pool_init(pool *, int capacity);
+
+/* Take a free slot, lowest first on a fresh pool.  Returns -1 if full. */
+extern int pool_acquire(pool *);
+
+/* Return a live slot to the pool */
+extern void pool_release(pool *, int slot);
+
+/* Handle for a live slot */
+extern pool_handle pool_handle_of(const pool *, int slot);
+
+/* Slot a handle refers to, or -1 if it is POOL_NONE or stale */
+extern int pool_slot(const pool *, pool_handle);
+
+#endif
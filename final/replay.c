@@ -0,0 +1,177 @@
+#include "replay.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static FILE *record_log;
+
+int replay_record_open(const char *path, unsigned int seed) {
+
+    replay_header header = {
+        .magic = REPLAY_MAGIC,
+        .version = REPLAY_VERSION,
+        .entry_size = sizeof(replay_entry),
+        .seed = seed,
+    };
+
+    if ((record_log = fopen(path, "wb")) == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    if (fwrite(&header, sizeof(header), 1, record_log) != 1) {
+        perror(path);
+        replay_record_close();
+        return -1;
+    }
+
+    return 0;
+}
+
+static void record_entry(uint32_t tag, const void *data, size_t n) {
+
+    replay_entry entry = { .tag = tag };
+
+    if (!record_log) return;
+
+    memcpy(entry.data, data, n);
+
+    if (fwrite(&entry, sizeof(entry), 1, record_log) != 1) {
+        perror("session log write failed");
+        replay_record_close();
+    }
+}
+
+void replay_record_input(unsigned long frame, const controller_packet *packet) {
+
+    record_entry(frame, packet, sizeof(*packet));
+}
+
+void replay_record_detail(unsigned long frame, int level) {
+
+    uint8_t l = level;
+
+    record_entry(frame | REPLAY_DETAIL, &l, sizeof(l));
+}
+
+void replay_record_checksum(unsigned long frame, unsigned int checksum) {
+
+    uint32_t sum = checksum;
+
+    record_entry(frame | REPLAY_CHECKSUM, &sum, sizeof(sum));
+}
+
+void replay_record_close() {
+
+    if (record_log) fclose(record_log);
+    record_log = NULL;
+}
+
+
+/* Playback */
+
+static FILE *play_log;
+static replay_entry next;
+static int have_next;
+static unsigned long checked, mismatches, first_mismatch;
+
+static backend replay, *output;
+
+static void read_entry() {
+
+    have_next = fread(&next, sizeof(next), 1, play_log) == 1;
+}
+
+static int replay_poll(controller_packet *packet, unsigned long frame) {
+
+    /* Any checksum or detail change still ahead of the inputs belongs
+       to a tick we never ran; skip it */
+    while (have_next && (next.tag & REPLAY_KIND) &&
+           (next.tag & ~REPLAY_KIND) < frame)
+        read_entry();
+
+    if (!have_next) return -1;
+
+    if ((next.tag & REPLAY_KIND) || next.tag > frame) return 0;
+
+    memcpy(packet, next.data, sizeof(*packet));
+    read_entry();
+
+    return 1;
+}
+
+int replay_detail(unsigned long frame, int level) {
+
+    if (!have_next || next.tag != (frame | REPLAY_DETAIL)) return level;
+
+    level = next.data[0];
+    read_entry();
+
+    return level;
+}
+
+int replay_check(unsigned long frame, unsigned int checksum) {
+
+    uint32_t sum;
+
+    if (!have_next || next.tag != (frame | REPLAY_CHECKSUM)) return 0;
+
+    memcpy(&sum, next.data, sizeof(sum));
+    read_entry();
+
+    checked++;
+
+    if (sum == checksum) return 0;
+
+    if (!mismatches++) first_mismatch = frame;
+
+    return -1;
+}
+
+static void replay_close() {
+
+    if (mismatches)
+        printf("replay diverged: %lu of %lu checksums differ, first at tick %lu\n",
+               mismatches, checked, first_mismatch);
+    else
+        printf("replay matched: %lu checksums\n", checked);
+
+    fclose(play_log);
+    output->close();
+}
+
+backend *replay_backend_open(const char *log_path, const char *record_path,
+                             unsigned int *seed) {
+
+    replay_header header;
+
+    if ((play_log = fopen(log_path, "rb")) == NULL) {
+        perror(log_path);
+        return NULL;
+    }
+
+    if (fread(&header, sizeof(header), 1, play_log) != 1 ||
+        header.magic != REPLAY_MAGIC || header.version != REPLAY_VERSION ||
+        header.entry_size != sizeof(replay_entry)) {
+
+        fprintf(stderr, "%s is not a version %d session log\n", log_path, REPLAY_VERSION);
+        fclose(play_log);
+        return NULL;
+    }
+
+    /* Frames go wherever the headless backend sends them */
+    if ((output = headless_backend_open(NULL, record_path)) == NULL) {
+        fclose(play_log);
+        return NULL;
+    }
+
+    *seed = header.seed;
+    read_entry();
+
+    replay = *output;
+    replay.name = "replay";
+    replay.poll = replay_poll;
+    replay.close = replay_close;
+
+    return &replay;
+}
@@ -0,0 +1,69 @@
+#ifndef _REPLAY_H
+#define _REPLAY_H
+
+#include <stdint.h>
+#include "backend.h"
+#include "input.h"
+
+/*
+ * Session logs for deterministic replay.  A log is a header carrying
+ * the rand() seed, then 12-byte entries in the order they happened:
+ *
+ *     input     tag = tick,                   data = the controller_packet
+ *     checksum  tag = tick | REPLAY_CHECKSUM, data[0..3] = game_checksum()
+ *                                             after that tick
+ *     detail    tag = tick | REPLAY_DETAIL,   data[0] = the level of detail
+ *                                             that tick and on ran at
+ *
+ * Fields are in host byte order; the board and x86 hosts are both
+ * little-endian.
+ */
+#define REPLAY_MAGIC 0x4c524453     /* "SDRL" */
+#define REPLAY_VERSION 2
+#define REPLAY_CHECKSUM 0x80000000u
+#define REPLAY_DETAIL 0x40000000u
+#define REPLAY_KIND (REPLAY_CHECKSUM | REPLAY_DETAIL)
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entry_size;            /* sizeof(replay_entry) */
+    uint32_t seed;
+} replay_header;
+
+typedef struct {
+    uint32_t tag;
+    uint8_t data[8];
+} replay_entry;
+
+/* Start logging a session played with the given seed.  Returns 0 on
+   success. */
+extern int replay_record_open(const char *path, unsigned int seed);
+
+/* Log a report handed to the game before tick frame */
+extern void replay_record_input(unsigned long frame, const controller_packet *);
+
+/* Log a change of the level of detail, made just before tick frame */
+extern void replay_record_detail(unsigned long frame, int level);
+
+/* Log the state checksum after tick frame */
+extern void replay_record_checksum(unsigned long frame, unsigned int checksum);
+
+extern void replay_record_close(void);
+
+/* Play a log back as input, unpaced.  Frames are thrown away or
+   appended to record_path like the headless backend does.  Stores the
+   session's seed.  Returns NULL if the log cannot be read. */
+extern backend *replay_backend_open(const char *log_path,
+                                    const char *record_path,
+                                    unsigned int *seed);
+
+/* Level of detail the log changed to before tick frame, or level if
+   it did not change it */
+extern int replay_detail(unsigned long frame, int level);
+
+/* Compare the state after tick frame with the log.  Returns 0 if it
+   matches or the log has no checksum for that tick, -1 on a mismatch. */
+extern int replay_check(unsigned long frame, unsigned int checksum);
+
+#endif
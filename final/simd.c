@@ -0,0 +1,136 @@
+#include "simd.h"
+
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define USE_NEON 1
+#endif
+
+#ifdef USE_NEON
+
+/* 0xffff in every lane whose live byte is non-zero */
+static inline uint16x8_t live_lanes(const bool *live){
+
+    return vtstq_u16(vmovl_u8(vld1_u8((const uint8_t *) live)),
+                     vdupq_n_u16(0xffff));
+}
+
+#endif
+
+#ifdef USE_NEON
+
+/* One axis of simd_integrate for 8 lanes; masked lanes see velo 0 */
+static inline void integrate_lanes(unsigned short *pos, unsigned char *sub,
+                                   const short *velo, uint16x8_t m){
+
+    int16x8_t v = vreinterpretq_s16_u16(vandq_u16(vreinterpretq_u16_s16(vld1q_s16(velo)), m));
+    uint16x8_t frac = vandq_u16(vreinterpretq_u16_s16(v), vdupq_n_u16(0xff));
+    uint16x8_t sum = vaddq_u16(vmovl_u8(vld1_u8(sub)), frac);
+    uint16x8_t step = vaddq_u16(vreinterpretq_u16_s16(vshrq_n_s16(v, 8)),
+                                vshrq_n_u16(sum, 8));
+
+    vst1q_u16(pos, vaddq_u16(vld1q_u16(pos), step));
+    vst1_u8(sub, vmovn_u16(sum));
+}
+
+#endif
+
+/* Scalar version of integrate_lanes() for one entity */
+static inline void integrate_one(unsigned short *pos, unsigned char *sub, short velo){
+
+    int acc = *sub + (velo & 0xff);
+
+    *pos += (velo >> 8) + (acc >> 8);
+    *sub = acc & 0xff;
+}
+
+void simd_integrate(unsigned short *pos_x, unsigned short *pos_y,
+                    unsigned char *sub_x, unsigned char *sub_y,
+                    const short *velo_x, const short *velo_y,
+                    const bool *live, int n){
+
+    int i = 0;
+
+#ifdef USE_NEON
+    for (; i + 8 <= n; i += 8){
+
+        uint16x8_t m = live_lanes(live + i);
+
+        integrate_lanes(pos_x + i, sub_x + i, velo_x + i, m);
+        integrate_lanes(pos_y + i, sub_y + i, velo_y + i, m);
+    }
+#endif
+
+    for (; i < n; i++){
+
+        if (!live[i]) continue;
+
+        integrate_one(&pos_x[i], &sub_x[i], velo_x[i]);
+        integrate_one(&pos_y[i], &sub_y[i], velo_y[i]);
+    }
+}
+
+void simd_shift_x(unsigned short *pos_x, short dx, const bool *live, int n){
+
+    int i = 0;
+
+#ifdef USE_NEON
+    uint16x8_t d = vdupq_n_u16((unsigned short) dx);
+
+    for (; i + 8 <= n; i += 8)
+        vst1q_u16(pos_x + i, vaddq_u16(vld1q_u16(pos_x + i),
+                                       vandq_u16(d, live_lanes(live + i))));
+#endif
+
+    for (; i < n; i++)
+        if (live[i]) pos_x[i] += dx;
+}
+
+int simd_hit_mask(const unsigned short *pos_x, const unsigned short *pos_y,
+                  const bool *live, int n, unsigned short x, unsigned short y,
+                  unsigned short half_w, unsigned short half_h,
+                  unsigned char *mask){
+
+    int i = 0, hits = 0;
+
+#ifdef USE_NEON
+    static const uint8_t bit_weights[8] = { 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x8_t weights = vld1_u8(bit_weights);
+    uint16x8_t vx = vdupq_n_u16(x), vy = vdupq_n_u16(y);
+    uint16x8_t hw = vdupq_n_u16(half_w), hh = vdupq_n_u16(half_h);
+
+    for (; i + 8 <= n; i += 8){
+
+        uint16x8_t dx = vabdq_u16(vld1q_u16(pos_x + i), vx);
+        uint16x8_t dy = vabdq_u16(vld1q_u16(pos_y + i), vy);
+        uint16x8_t hit = vandq_u16(live_lanes(live + i),
+                                   vandq_u16(vcleq_u16(dx, hw), vcleq_u16(dy, hh)));
+
+        /* Fold the 8 lane flags into one byte */
+        uint8x8_t b = vand_u8(vmovn_u16(hit), weights);
+        b = vpadd_u8(b, b);
+        b = vpadd_u8(b, b);
+        b = vpadd_u8(b, b);
+
+        mask[i >> 3] = vget_lane_u8(b, 0);
+        hits += __builtin_popcount(mask[i >> 3]);
+    }
+#endif
+
+    memset(mask + (i >> 3), 0, HIT_MASK_BYTES(n) - (i >> 3));
+
+    for (; i < n; i++){
+
+        int dx = pos_x[i] > x ? pos_x[i] - x : x - pos_x[i];
+        int dy = pos_y[i] > y ? pos_y[i] - y : y - pos_y[i];
+
+        if (live[i] && dx <= half_w && dy <= half_h){
+
+            mask[i >> 3] |= 1 << (i & 7);
+            hits++;
+        }
+    }
+
+    return hits;
+}
@@ -0,0 +1,40 @@
+#ifndef _SIMD_H
+#define _SIMD_H
+
+#include <stdbool.h>
+
+/*
+ * Per-entity kernels over the structure-of-arrays stores.  On ARM with
+ * NEON (the DE1-SoC's Cortex-A9) they handle 8 entities per
+ * instruction; everywhere else the same functions are plain C, so the
+ * game and its benchmarks build on any host.
+ */
+
+/* Bytes needed for a hit mask over n entities, one bit per entity */
+#define HIT_MASK_BYTES(n) (((n) + 7) / 8)
+
+/* Bit i of a hit mask */
+#define HIT(mask, i) (((mask)[(i) >> 3] >> ((i) & 7)) & 1)
+
+/* pos += velo for every entity whose live flag is set.  velo is Q8.8;
+   its fraction accumulates in sub and carries into pos. */
+extern void simd_integrate(unsigned short *pos_x, unsigned short *pos_y,
+                           unsigned char *sub_x, unsigned char *sub_y,
+                           const short *velo_x, const short *velo_y,
+                           const bool *live, int n);
+
+/* pos_x += dx for every entity whose live flag is set */
+extern void simd_shift_x(unsigned short *pos_x, short dx,
+                         const bool *live, int n);
+
+/* Set bit i of mask for every live entity with |pos_x - x| <= half_w
+   and |pos_y - y| <= half_h, clear the rest.  Distances are taken on
+   the unsigned positions, as abs() on the promoted values would.
+   Returns the number of hits. */
+extern int simd_hit_mask(const unsigned short *pos_x,
+                         const unsigned short *pos_y, const bool *live,
+                         int n, unsigned short x, unsigned short y,
+                         unsigned short half_w, unsigned short half_h,
+                         unsigned char *mask);
+
+#endif
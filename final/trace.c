@@ -0,0 +1,76 @@
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdatomic.h>
+
+const char *const trace_phase_names[TRACE_PHASES] = {
+    [TRACE_INPUT] = "input",
+    [TRACE_STEP] = "step",
+    [TRACE_PACK] = "pack",
+    [TRACE_COMMIT] = "commit",
+    [TRACE_SLEEP] = "sleep",
+    [TRACE_AI] = "ai",
+    [TRACE_SHIP_BULLETS] = "ship_bullets",
+    [TRACE_ENEMY_BULLETS] = "enemy_bullets",
+};
+
+/* The commit thread records into the same ring, so claim slots
+   atomically; the frame tag it reads may be a tick stale */
+static trace_event ring[TRACE_RING_SIZE];
+static atomic_ulong recorded;
+static atomic_uint frame;
+
+void trace_record(int phase, uint64_t start) {
+
+    unsigned long n = atomic_fetch_add_explicit(&recorded, 1, memory_order_relaxed);
+    trace_event *ev = &ring[n & (TRACE_RING_SIZE - 1)];
+
+    ev->start_ns = start;
+    ev->duration_ns = trace_now() - start;
+    ev->tag = TRACE_TAG(atomic_load_explicit(&frame, memory_order_relaxed), phase);
+
+    if (perf_enabled) perf_pop(phase);
+}
+
+void trace_set_frame(unsigned long f) {
+
+    atomic_store_explicit(&frame, f, memory_order_relaxed);
+}
+
+int trace_dump(const char *path) {
+
+    FILE *f;
+    unsigned long first = 0, count = recorded;
+    trace_header header = {
+        .magic = TRACE_MAGIC,
+        .version = TRACE_VERSION,
+        .phases = TRACE_PHASES,
+    };
+
+    /* Once the ring has wrapped the oldest event sits at the write index */
+    if (count > TRACE_RING_SIZE) {
+        first = recorded & (TRACE_RING_SIZE - 1);
+        count = TRACE_RING_SIZE;
+    }
+
+    header.count = count;
+    header.lost = recorded - count;
+
+    if ((f = fopen(path, "wb")) == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    fwrite(&header, sizeof(header), 1, f);
+
+    /* Oldest first: the tail of the ring, then the head */
+    fwrite(ring + first, sizeof(trace_event), count - first, f);
+    fwrite(ring, sizeof(trace_event), first, f);
+
+    if (fclose(f)) {
+        perror(path);
+        return -1;
+    }
+
+    return 0;
+}
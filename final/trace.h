@@ -0,0 +1,107 @@
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include <stdint.h>
+#include <time.h>
+#include "perf.h"
+
+/*
+ * Per-phase frame timing.  Each traced phase drops a timestamped event
+ * into a fixed in-memory ring; nothing is printed while the game runs.
+ * trace_dump() writes the ring out at exit and trace_summary turns the
+ * file into p50/p99/max per phase.
+ *
+ * When perf_open() has succeeded the same points also sample the
+ * hardware counters (see perf.h).
+ *
+ * TRACE_LEVEL picks what is compiled in:
+ *   0  nothing: the macros expand to no code
+ *   1  the frame loop: input, simulation tick, packing, commit, sleep
+ *   2  also the parts of a tick: AI, ship bullets, enemy bullets
+ */
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL 1
+#endif
+
+enum {
+    TRACE_INPUT,            /* draining the pad and applying reports */
+    TRACE_STEP,             /* one game_step() */
+    TRACE_PACK,             /* game_pack() */
+    TRACE_COMMIT,           /* handing the frame to the backend (the ioctl) */
+    TRACE_SLEEP,            /* frame_timer_wait() */
+    TRACE_AI,               /* picking and moving divers, ship collision */
+    TRACE_SHIP_BULLETS,     /* ship bullets against the enemies */
+    TRACE_ENEMY_BULLETS,    /* enemy bullets against the ship */
+    TRACE_PHASES
+};
+
+extern const char *const trace_phase_names[TRACE_PHASES];
+
+/* Events kept; older ones are overwritten.  Must be a power of two. */
+#define TRACE_RING_SIZE 65536
+
+typedef struct {
+    uint64_t start_ns;      /* CLOCK_MONOTONIC */
+    uint32_t duration_ns;
+    uint32_t tag;           /* tick << 8 | phase */
+} trace_event;
+
+#define TRACE_TAG(frame, phase) ((uint32_t) (frame) << 8 | (phase))
+#define TRACE_TAG_PHASE(tag) ((tag) & 0xff)
+#define TRACE_TAG_FRAME(tag) ((tag) >> 8)
+
+/* Dump file: this header, then count events oldest first */
+#define TRACE_MAGIC 0x52544453      /* "SDTR" */
+#define TRACE_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t phases;        /* TRACE_PHASES of the writer */
+    uint32_t count;         /* events in the file */
+    uint32_t lost;          /* events overwritten before the dump */
+} trace_header;
+
+static inline uint64_t trace_now(void) {
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+/* Start of a phase: the time, and the counters if they are open */
+static inline uint64_t trace_begin(void) {
+
+    if (perf_enabled) perf_push();
+
+    return trace_now();
+}
+
+/* Log phase as running from start until now */
+extern void trace_record(int phase, uint64_t start);
+
+/* Tick number stamped on the events that follow */
+extern void trace_set_frame(unsigned long);
+
+/* Write the ring to path.  Returns 0 on success. */
+extern int trace_dump(const char *path);
+
+#if TRACE_LEVEL >= 1
+#define TRACE_BEGIN(t) uint64_t t = trace_begin()
+#define TRACE_END(phase, t) trace_record(phase, t)
+#else
+#define TRACE_BEGIN(t)
+#define TRACE_END(phase, t) ((void) 0)
+#endif
+
+#if TRACE_LEVEL >= 2
+#define TRACE2_BEGIN(t) TRACE_BEGIN(t)
+#define TRACE2_END(phase, t) TRACE_END(phase, t)
+#else
+#define TRACE2_BEGIN(t)
+#define TRACE2_END(phase, t) ((void) 0)
+#endif
+
+#endif
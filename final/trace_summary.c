@@ -0,0 +1,86 @@
+/*
+ * Summarise a trace written by hello -t: per phase, how many events
+ * and the p50, p99 and max duration in microseconds.
+ *
+ *     trace_summary trace.bin
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "trace.h"
+
+static int compare_u32(const void *a, const void *b) {
+
+    uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of n sorted durations */
+static double percentile_us(const uint32_t *sorted, unsigned long n, int p) {
+
+    unsigned long rank = (p * n + 99) / 100;
+
+    return sorted[rank ? rank - 1 : 0] / 1000.0;
+}
+
+int main(int argc, char *argv[]) {
+
+    FILE *f;
+    trace_header header;
+    trace_event ev;
+    uint32_t *durations[TRACE_PHASES];
+    unsigned long counts[TRACE_PHASES] = { 0 };
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s trace.bin\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if ((f = fopen(argv[1], "rb")) == NULL) {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    if (fread(&header, sizeof(header), 1, f) != 1 || header.magic != TRACE_MAGIC ||
+        header.version != TRACE_VERSION || header.phases != TRACE_PHASES) {
+        fprintf(stderr, "%s is not a version %d trace\n", argv[1], TRACE_VERSION);
+        return EXIT_FAILURE;
+    }
+
+    for (int p = 0; p < TRACE_PHASES; p++)
+        if ((durations[p] = malloc(header.count * sizeof(uint32_t))) == NULL) {
+            perror("malloc");
+            return EXIT_FAILURE;
+        }
+
+    for (uint32_t i = 0; i < header.count && fread(&ev, sizeof(ev), 1, f) == 1; i++) {
+
+        int p = TRACE_TAG_PHASE(ev.tag);
+
+        if (p < TRACE_PHASES) durations[p][counts[p]++] = ev.duration_ns;
+    }
+
+    fclose(f);
+
+    printf("%u events", header.count);
+    if (header.lost) printf(" (%u older events overwritten)", header.lost);
+    printf("\n%-14s %8s %10s %10s %10s\n", "phase", "count", "p50_us", "p99_us", "max_us");
+
+    for (int p = 0; p < TRACE_PHASES; p++) {
+
+        unsigned long n = counts[p];
+
+        if (!n) continue;
+
+        qsort(durations[p], n, sizeof(uint32_t), compare_u32);
+
+        printf("%-14s %8lu %10.2f %10.2f %10.2f\n", trace_phase_names[p], n,
+               percentile_us(durations[p], n, 50), percentile_us(durations[p], n, 99),
+               durations[p][n - 1] / 1000.0);
+
+        free(durations[p]);
+    }
+
+    return 0;
+}
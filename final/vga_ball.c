@@ -17,6 +17,13 @@
 #include <linux/of_address.h>
 #include <linux/fs.h>
 #include <linux/uaccess.h>
+#include <linux/interrupt.h>
+#include <linux/of_irq.h>
+#include <linux/poll.h>
+#include <linux/wait.h>
+#include <linux/sched.h>
+#include <linux/mm.h>
+#include <linux/spinlock.h>
 #include "vga_ball.h"
 
 #define DRIVER_NAME "vga_ball"
@@ -24,6 +31,10 @@
 /* Device registers */
 #define BG_COLOR(x)      (x)
 #define OBJECT_DATA(x,i) ((x) + (4*(i)))
+#define VBLANK_CTRL(x)   ((x) + (4*127))
+
+/* VBLANK_CTRL bits: any write acknowledges the pending interrupt */
+#define VBLANK_IRQ_ENABLE 0x1
 
 /*
 * Information about our device
@@ -37,6 +48,15 @@ struct vga_ball_dev {
     enemy enemies[ENEMY_COUNT];
     powerup power_up;
     int score;
+    u32 objects[FRAME_WORDS];       /* last word written to each OBJECT_DATA */
+    frame_words *shadow;            /* page userspace mmap()s and packs into */
+    u32 staged[FRAME_WORDS];        /* committed frame waiting for vblank */
+    bool commit_pending;
+    spinlock_t commit_lock;         /* staged/commit_pending vs. the irq */
+    int irq;                        /* vblank interrupt, 0 if not wired */
+    wait_queue_head_t vblank_wait;  /* readers waiting for the next vblank */
+    u32 vblank_count;               /* vblanks seen since probe */
+    vga_ball_stats stats;           /* OBJECT_DATA writes issued vs. skipped */
 } dev;
 
 /*
@@ -53,25 +73,59 @@ static void write_background(background_color *background)
 }
 
 
+/*
+ * Write one OBJECT_DATA register unless it already holds that word.
+ * Bus writes to the FPGA are the slow part, so unchanged and still
+ * inactive objects cost nothing.
+ */
+static void write_word(int idx, u32 word)
+{
+    if (dev.objects[idx] == word) {
+        dev.stats.frame_skipped++;
+        return;
+    }
+
+    iowrite32(word, OBJECT_DATA(dev.virtbase, idx));
+    dev.objects[idx] = word;
+    dev.stats.frame_writes++;
+}
+
+/*
+ * Close the per-frame write counters
+ */
+static void end_frame(void)
+{
+    dev.stats.frames++;
+    dev.stats.writes += dev.stats.frame_writes;
+    dev.stats.skipped += dev.stats.frame_skipped;
+    dev.stats.last_writes = dev.stats.frame_writes;
+    dev.stats.last_skipped = dev.stats.frame_skipped;
+    dev.stats.frame_writes = dev.stats.frame_skipped = 0;
+}
+
+/*
+ * Write every object register so dev.objects matches the hardware
+ */
+static void sync_objects(void)
+{
+    int i;
+
+    for (i = SCORE_SLOT; i < FRAME_WORDS; i++)
+        iowrite32(dev.objects[i], OBJECT_DATA(dev.virtbase, i));
+}
+
 /*
  * Write object data
  */
 static void write_object(int idx, unsigned short x, unsigned short y, char sprite_idx, char active)
 {
-    // 构建32位对象数据
-    u32 obj_data = ((u32)(x & 0xFFF) << 20) |   // x位置 (12位)
-                ((u32)(y & 0xFFF) << 8) |    // y位置 (12位)
-                ((u32)(sprite_idx & 0x3F) << 2) | // 精灵索引 (6位)
-                ((u32)(active & 0x1) << 1);  // 活动状态 (1位)
-                
-    iowrite32(obj_data, OBJECT_DATA(dev.virtbase, idx));
+    // 构建32位对象数据: x(12位) y(12位) 精灵索引(6位) 活动状态(1位)
+    write_word(idx, OBJECT_WORD(x, y, sprite_idx, active));
 }
 
 static void write_score(int idx, int score)
 {
-    u32 obj_data = (uint32_t)(score & 0xFFFFFFFF);
-
-    iowrite32(obj_data, OBJECT_DATA(dev.virtbase, idx));
+    write_word(idx, (u32) score);
 
     dev.score = score;
 }
@@ -91,12 +145,12 @@ static void write_ship(spaceship *ship){
 
     else sprite = SHIP;
 
-    write_object (2, ship->pos_x,  ship->pos_y, sprite, ship->active);
+    write_object (SHIP_SLOT, ship->pos_x,  ship->pos_y, sprite, ship->active);
 
     if (ship->velo_y < 0 && ship->active & !ship->explosion_timer) active = 1;
     else active = 0;
 
-    write_object (3, ship->pos_x,  ship->pos_y+SHIP_HEIGHT, SHIP_FLAME, active);
+    write_object (FLAME_SLOT, ship->pos_x,  ship->pos_y+SHIP_HEIGHT, SHIP_FLAME, active);
 
     dev.ship = *ship;
 
@@ -105,7 +159,7 @@ static void write_ship(spaceship *ship){
         if(i<ship->lives) active = 1;
         else active = 0;
 
-        write_object (i+4, i*20+10,  SCREEN_HEIGHT-16, SHIP, active);
+        write_object (i+LIFE_SLOT, i*20+10,  SCREEN_HEIGHT-16, SHIP, active);
     }
 }
 
@@ -117,7 +171,7 @@ static void write_ship_bullets(spaceship *ship){
     for (i = 0; i < SHIP_BULLETS; i++) {
 
         bul = &ship->bullets[i];
-        write_object (i+LIFE_COUNT+4, bul->pos_x,  bul->pos_y, SHIP_BULLET, bul->active);
+        write_object (i+SHIP_BULLET_SLOT, bul->pos_x,  bul->pos_y, SHIP_BULLET, bul->active);
 
         dev.ship.bullets[i] = *bul;
     }
@@ -139,7 +193,7 @@ static void write_enemies(bullet bullets[], enemy enemies[])
 
         enemy = &enemies[i];
 
-        write_object(i+SHIP_BULLETS+LIFE_COUNT+4,  enemy->pos_x,  enemy->pos_y, enemy->sprite, enemy->active);
+        write_object(i+ENEMY_SLOT,  enemy->pos_x,  enemy->pos_y, enemy->sprite, enemy->active);
         dev.enemies[i] = enemies[i];
     }
 
@@ -153,7 +207,7 @@ static void write_enemies(bullet bullets[], enemy enemies[])
 
         else sprite = ENEMY_BULLET;
 
-        write_object(i+SHIP_BULLETS+LIFE_COUNT+ENEMY_COUNT+4,  bul->pos_x,  bul->pos_y, sprite, bul->active);
+        write_object(i+ENEMY_BULLET_SLOT,  bul->pos_x,  bul->pos_y, sprite, bul->active);
         dev.bullets[i] = *bul;
     }
 }
@@ -162,7 +216,7 @@ static void write_enemies(bullet bullets[], enemy enemies[])
 
 static void write_powerup(powerup *power_up){
 
-    write_object (SHIP_BULLETS+LIFE_COUNT+ENEMY_COUNT+MAX_BULLETS+4, power_up->pos_x,  power_up->pos_y, power_up->sprite, power_up->active);
+    write_object (POWERUP_SLOT, power_up->pos_x,  power_up->pos_y, power_up->sprite, power_up->active);
 
     dev.power_up = *power_up;
 
@@ -176,46 +230,130 @@ static void update_enemies(gamestate *game_state)
 {
     // write_background(&game_state->background);
 
-    write_score(1, game_state->score);
+    write_score(SCORE_SLOT, game_state->score);
 
     write_enemies(game_state->bullets, game_state->enemies);
 }
 
 
+/*
+ * Write a whole frame that userspace has already packed
+ */
+static void write_words(const u32 *words)
+{
+    int i;
+
+    for (i = SCORE_SLOT; i < FRAME_WORDS; i++)
+        write_word(i, words[i]);
+
+    end_frame();
+}
+
+/*
+ * Called with commit_lock held: flush a committed shadow frame
+ */
+static void flush_staged(void)
+{
+    if (dev.commit_pending) {
+        write_words(dev.staged);
+        dev.commit_pending = false;
+    }
+}
+
+/*
+ * Snapshot the mmap()ed shadow page.  With a vblank interrupt the
+ * snapshot goes out at the next vblank so the table never changes
+ * mid-scanout; otherwise it is written straight away.
+ */
+static void commit_shadow(void)
+{
+    unsigned long flags;
+
+    spin_lock_irqsave(&dev.commit_lock, flags);
+
+    memcpy(dev.staged, dev.shadow->words, sizeof(dev.staged));
+    dev.commit_pending = true;
+
+    if (!dev.irq)
+        flush_staged();
+
+    spin_unlock_irqrestore(&dev.commit_lock, flags);
+}
+
+
 static gamestate vb_arg;
 static spaceship vb_ship;
 static powerup vb_pu;
+static frame_words vb_frame;
+static vga_ball_stats vb_stats;
 
 /*
 * Handle ioctl() calls from userspace
 */
 static long vga_ball_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
 {
+    unsigned long flags;
+
+    /* The old per-part updates write the same registers as a commit
+       at vblank, so they take commit_lock too, and each counts as a
+       frame of its own in the stats */
     switch (cmd) {
         case UPDATE_ENEMIES:
             if (copy_from_user(&vb_arg, (gamestate *) arg, sizeof(gamestate)))
                 return -EACCES;
+            spin_lock_irqsave(&dev.commit_lock, flags);
             update_enemies(&vb_arg);
+            end_frame();
+            spin_unlock_irqrestore(&dev.commit_lock, flags);
             break;
 
         case UPDATE_SHIP:
             if (copy_from_user(&vb_ship, (spaceship *) arg, sizeof(spaceship)))
                 return -EACCES;
+            spin_lock_irqsave(&dev.commit_lock, flags);
             write_ship(&vb_ship);
+            end_frame();
+            spin_unlock_irqrestore(&dev.commit_lock, flags);
             break;
 
         case UPDATE_SHIP_BULLETS:
             if (copy_from_user(&vb_ship, (spaceship *) arg, sizeof(spaceship)))
                 return -EACCES;
+            spin_lock_irqsave(&dev.commit_lock, flags);
             write_ship_bullets(&vb_ship);
+            end_frame();
+            spin_unlock_irqrestore(&dev.commit_lock, flags);
             break;
 
         case UPDATE_POWERUP:
             if (copy_from_user(&vb_pu, (powerup *) arg, sizeof(powerup)))
                 return -EACCES;
+            spin_lock_irqsave(&dev.commit_lock, flags);
             write_powerup(&vb_pu);
+            end_frame();
+            spin_unlock_irqrestore(&dev.commit_lock, flags);
+            break;
+
+        case UPDATE_FRAME:
+            if (copy_from_user(&vb_frame, (frame_words *) arg, sizeof(frame_words)))
+                return -EACCES;
+            spin_lock_irqsave(&dev.commit_lock, flags);
+            write_words(vb_frame.words);
+            spin_unlock_irqrestore(&dev.commit_lock, flags);
             break;
 
+        case COMMIT_FRAME:
+            commit_shadow();
+            break;
+
+        case READ_STATS:
+            spin_lock_irqsave(&dev.commit_lock, flags);
+            vb_stats = dev.stats;
+            spin_unlock_irqrestore(&dev.commit_lock, flags);
+
+            if (copy_to_user((vga_ball_stats *) arg, &vb_stats, sizeof(vga_ball_stats)))
+                return -EACCES;
+            break;
 
 
         default:
@@ -225,9 +363,108 @@ static long vga_ball_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
     return 0;
 }
 
+/*
+* Vertical blank: acknowledge it and wake anyone waiting for a new frame
+*/
+static irqreturn_t vga_ball_irq(int irq, void *data)
+{
+    iowrite32(VBLANK_IRQ_ENABLE, VBLANK_CTRL(dev.virtbase));
+
+    spin_lock(&dev.commit_lock);
+    flush_staged();
+    spin_unlock(&dev.commit_lock);
+
+    WRITE_ONCE(dev.vblank_count, dev.vblank_count + 1);
+    wake_up_interruptible(&dev.vblank_wait);
+
+    return IRQ_HANDLED;
+}
+
+/*
+* Each open file remembers the last vblank it was told about
+*/
+static int vga_ball_open(struct inode *inode, struct file *f)
+{
+    f->private_data = (void *)(unsigned long)READ_ONCE(dev.vblank_count);
+    return 0;
+}
+
+/*
+* read() blocks until a vblank this file has not seen yet, then returns
+* the 32-bit vblank count.  A jump of more than one means frames were
+* missed.
+*/
+static ssize_t vga_ball_read(struct file *f, char __user *buf, size_t len,
+                             loff_t *off)
+{
+    u32 seen = (u32)(unsigned long)f->private_data;
+    u32 count;
+
+    if (!dev.irq)
+        return -ENODEV;
+
+    if (len < sizeof(count))
+        return -EINVAL;
+
+    if (f->f_flags & O_NONBLOCK) {
+        if (READ_ONCE(dev.vblank_count) == seen)
+            return -EAGAIN;
+    }
+    else if (wait_event_interruptible(dev.vblank_wait,
+                                      READ_ONCE(dev.vblank_count) != seen))
+        return -ERESTARTSYS;
+
+    count = READ_ONCE(dev.vblank_count);
+    f->private_data = (void *)(unsigned long)count;
+
+    if (copy_to_user(buf, &count, sizeof(count)))
+        return -EFAULT;
+
+    return sizeof(count);
+}
+
+static unsigned int vga_ball_poll(struct file *f, poll_table *wait)
+{
+    u32 seen = (u32)(unsigned long)f->private_data;
+
+    if (!dev.irq)
+        return POLLERR;
+
+    poll_wait(f, &dev.vblank_wait, wait);
+
+    if (READ_ONCE(dev.vblank_count) != seen)
+        return POLLIN | POLLRDNORM;
+
+    return 0;
+}
+
+/*
+* Map the shadow object table into userspace
+*/
+static int vga_ball_mmap(struct file *f, struct vm_area_struct *vma)
+{
+    if (vma->vm_pgoff != 0 || vma->vm_end - vma->vm_start > PAGE_SIZE)
+        return -EINVAL;
+
+    /* One page only, and kept out of core dumps */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+    vm_flags_set(vma, VM_DONTEXPAND | VM_DONTDUMP);
+#else
+    vma->vm_flags |= VM_DONTEXPAND | VM_DONTDUMP;
+#endif
+
+    return remap_pfn_range(vma, vma->vm_start,
+                           virt_to_phys(dev.shadow) >> PAGE_SHIFT,
+                           vma->vm_end - vma->vm_start, vma->vm_page_prot);
+}
+
 /* The operations our device knows how to do */
 static const struct file_operations vga_ball_fops = {
     .owner          = THIS_MODULE,
+    .open           = vga_ball_open,
+    .read           = vga_ball_read,
+    .poll           = vga_ball_poll,
+    .mmap           = vga_ball_mmap,
     .unlocked_ioctl = vga_ball_ioctl,
 };
 
@@ -248,6 +485,15 @@ static int __init vga_ball_probe(struct platform_device *pdev)
 
     int ret;
 
+    init_waitqueue_head(&dev.vblank_wait);
+    spin_lock_init(&dev.commit_lock);
+
+    /* Shadow object table for mmap() */
+    dev.shadow = (frame_words *) get_zeroed_page(GFP_KERNEL);
+    if (dev.shadow == NULL)
+        return -ENOMEM;
+    SetPageReserved(virt_to_page(dev.shadow));
+
     /* Register ourselves as a misc device */
     ret = misc_register(&vga_ball_misc_device);
 
@@ -275,6 +521,19 @@ static int __init vga_ball_probe(struct platform_device *pdev)
         
     /* Set initial values */
     write_background(&background);
+    sync_objects();
+
+    /* The vblank interrupt is optional: without it read() and poll()
+       report -ENODEV and userspace paces itself */
+    dev.irq = irq_of_parse_and_map(pdev->dev.of_node, 0);
+    if (dev.irq) {
+        if (request_irq(dev.irq, vga_ball_irq, 0, DRIVER_NAME, &dev)) {
+            pr_warn(DRIVER_NAME ": could not claim irq %d\n", dev.irq);
+            dev.irq = 0;
+        }
+        else
+            iowrite32(VBLANK_IRQ_ENABLE, VBLANK_CTRL(dev.virtbase));
+    }
 
     return 0;
 
@@ -282,15 +541,23 @@ out_release_mem_region:
     release_mem_region(dev.res.start, resource_size(&dev.res));
 out_deregister:
     misc_deregister(&vga_ball_misc_device);
+    ClearPageReserved(virt_to_page(dev.shadow));
+    free_page((unsigned long) dev.shadow);
     return ret;
 }
 
 /* Clean-up code: release resources */
 static int vga_ball_remove(struct platform_device *pdev)
 {
+    if (dev.irq) {
+        iowrite32(0, VBLANK_CTRL(dev.virtbase));
+        free_irq(dev.irq, &dev);
+    }
     iounmap(dev.virtbase);
     release_mem_region(dev.res.start, resource_size(&dev.res));
     misc_deregister(&vga_ball_misc_device);
+    ClearPageReserved(virt_to_page(dev.shadow));
+    free_page((unsigned long) dev.shadow);
     return 0;
 }
 
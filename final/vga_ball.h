@@ -6,8 +6,15 @@
 
 /* 定义最大子弹数量 */
 #define SHIP_BULLETS 5
+
+/* The benchmarks rebuild the game with more of these; the driver and
+   the display always use the defaults */
+#ifndef MAX_BULLETS
 #define MAX_BULLETS 15
+#endif
+#ifndef ENEMY_COUNT
 #define ENEMY_COUNT 60
+#endif
 
 #define SHIP_WIDTH 16
 #define SHIP_HEIGHT 16
@@ -88,6 +95,39 @@ typedef struct {
     int score;
 } gamestate;
 
+/* OBJECT_DATA register each part of the game is drawn into */
+#define SCORE_SLOT 1
+#define SHIP_SLOT 2
+#define FLAME_SLOT 3
+#define LIFE_SLOT 4
+#define SHIP_BULLET_SLOT (LIFE_SLOT + LIFE_COUNT)
+#define ENEMY_SLOT (SHIP_BULLET_SLOT + SHIP_BULLETS)
+#define ENEMY_BULLET_SLOT (ENEMY_SLOT + ENEMY_COUNT)
+#define POWERUP_SLOT (ENEMY_BULLET_SLOT + MAX_BULLETS)
+#define FRAME_WORDS (POWERUP_SLOT + 1)
+
+/* One OBJECT_DATA word: x[31:20] y[19:8] sprite[7:2] active[1] */
+#define OBJECT_WORD(x, y, sprite, active) \
+    ((((unsigned int)(x) & 0xFFF) << 20) | \
+     (((unsigned int)(y) & 0xFFF) << 8) | \
+     (((unsigned int)(sprite) & 0x3F) << 2) | \
+     (((unsigned int)(active) & 0x1) << 1))
+
+/* Every object register for one frame, already packed.  words[i] goes
+   to OBJECT_DATA(i); words[0] is the background and is not written. */
+typedef struct {
+    unsigned int words[FRAME_WORDS];
+} frame_words;
+
+/* How many OBJECT_DATA writes the driver issued and how many it
+   skipped because the register already held that word */
+typedef struct {
+    unsigned int frames;                /* frames committed */
+    unsigned int last_writes, last_skipped;   /* in the last frame */
+    unsigned int frame_writes, frame_skipped; /* in the frame being built */
+    unsigned long long writes, skipped; /* since the driver loaded */
+} vga_ball_stats;
+
 #define VGA_BALL_MAGIC 'v'
 
 /* ioctls and their arguments */
@@ -95,6 +135,9 @@ typedef struct {
 #define UPDATE_SHIP   _IOW(VGA_BALL_MAGIC, 2, spaceship)
 #define UPDATE_SHIP_BULLETS   _IOW(VGA_BALL_MAGIC, 3, spaceship)
 #define UPDATE_POWERUP   _IOW(VGA_BALL_MAGIC, 4, powerup)
+#define UPDATE_FRAME   _IOW(VGA_BALL_MAGIC, 5, frame_words)
+#define COMMIT_FRAME   _IO(VGA_BALL_MAGIC, 6)  /* flush the mmap()ed frame_words */
+#define READ_STATS   _IOR(VGA_BALL_MAGIC, 7, vga_ball_stats)
 
 #endif /* _VGA_BALL_H */
 
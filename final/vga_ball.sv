@@ -18,7 +18,8 @@ module vga_ball#(
     output logic [7:0]  VGA_R, VGA_G, VGA_B,
     output logic        VGA_CLK, VGA_HS, VGA_VS,
     output logic        VGA_BLANK_n,
-    output logic        VGA_SYNC_n
+    output logic        VGA_SYNC_n,
+    output logic        irq         // vblank 中断，接 HPS f2h_irq0
 );
 
     // 常量定义
@@ -156,6 +157,26 @@ module vga_ball#(
         end
     end
 
+    // Vertical blank interrupt
+    // 最后一行可见像素扫描完时置位，驱动写 VBLANK_CTRL (地址 127) 清除
+    // writedata[0] 是中断使能
+    localparam logic [6:0] VBLANK_CTRL = 7'd127;
+    logic vblank_irq_en, vblank_pending;
+
+    always_ff @(posedge clk or posedge reset) begin
+        if (reset) begin
+            vblank_irq_en  <= 1'b0;
+            vblank_pending <= 1'b0;
+        end else if (chipselect && write && address == VBLANK_CTRL) begin
+            vblank_irq_en  <= writedata[0];
+            vblank_pending <= 1'b0;
+        end else if (hcount == 11'd0 && vcount == 10'd480) begin
+            vblank_pending <= 1'b1;
+        end
+    end
+
+    assign irq = vblank_irq_en & vblank_pending;
+
     // star
     always_ff @(posedge clk or posedge reset) begin
         if (reset) begin
@@ -0,0 +1,175 @@
+/*
+ * Loading the wave file.  See wave.h for the layout.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "wave.h"
+#include "vga_ball.h"
+
+static const char *file_name;
+
+static int bad(const char *why) {
+
+    fprintf(stderr, "%s: %s\n", file_name, why);
+    return -1;
+}
+
+/* n bytes at offset fit in a file of size */
+static int inside(size_t size, uint32_t offset, size_t n) {
+
+    return offset <= size && n <= size - offset;
+}
+
+static int check_formation(const wave_file *w, int r) {
+
+    wave_formation f = wave_formation_of(w, r);
+    uint32_t taken[MAX_ROWS] = { 0 };      /* a bit per column */
+
+    for (int i = 0; i < f.count; i++) {
+
+        if (f.sprite[i] != ENEMY1 && f.sprite[i] != ENEMY2 && f.sprite[i] != ENEMY3)
+            return bad("unknown enemy sprite");
+
+        if (f.row[i] >= w->header->rows || f.col[i] >= w->header->columns)
+            return bad("enemy outside the grid");
+
+        if (taken[f.row[i]] >> f.col[i] & 1)
+            return bad("two enemies in one cell");
+
+        taken[f.row[i]] |= 1u << f.col[i];
+
+        if (f.path[i] >= w->header->paths)
+            return bad("enemy flies a missing path");
+    }
+
+    return 0;
+}
+
+static int check(const wave_file *w) {
+
+    const wave_header *h = w->header;
+    size_t tables = sizeof(*h) + h->rounds * sizeof(wave_round) + h->paths * sizeof(wave_path);
+
+    if (h->version != WAVE_VERSION) {
+
+        fprintf(stderr, "%s: version %d, this build reads %d\n",
+                file_name, h->version, WAVE_VERSION);
+        return -1;
+    }
+
+    if (h->size != w->size) return bad("truncated");
+    if (tables > w->size) return bad("tables run past the end");
+
+    if (!h->columns || h->columns > MAX_COLUMNS || !h->rows || h->rows > MAX_ROWS)
+        return bad("formation grid too large");
+
+    if (!h->rounds || !h->paths) return bad("no rounds or no paths");
+
+    for (int p = 0; p < h->paths; p++) {
+
+        const wave_path *path = &w->paths[p];
+
+        if (!path->length || path->shift > 8 ||
+            path->samples != WAVE_SAMPLES(path->length, path->shift))
+            return bad("malformed path");
+
+        if (path->velocity % 2 ||
+            !inside(w->size, path->velocity, 2 * path->samples * sizeof(int16_t)))
+            return bad("path runs past the end");
+    }
+
+    for (int r = 0; r < h->rounds; r++) {
+
+        const wave_round *round = &w->rounds[r];
+
+        if (round->enemies > ENEMY_COUNT) return bad("more enemies than ENEMY_COUNT");
+        if (!round->every) return bad("round never sends an enemy");
+
+        if (round->formation % 2 ||
+            !inside(w->size, round->formation, WAVE_FORMATION_SIZE(round->enemies)))
+            return bad("formation runs past the end");
+
+        if (check_formation(w, r)) return -1;
+    }
+
+    return 0;
+}
+
+int wave_open(wave_file *w, const char *path) {
+
+    struct stat st;
+    void *map;
+    int fd;
+
+    file_name = path;
+
+    if ((fd = open(path, O_RDONLY)) == -1 || fstat(fd, &st) == -1) {
+
+        perror(path);
+        if (fd != -1) close(fd);
+        return -1;
+    }
+
+    if ((size_t) st.st_size < sizeof(wave_header)) {
+
+        close(fd);
+        return bad("not a wave file");
+    }
+
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+
+        perror(path);
+        return -1;
+    }
+
+    w->header = map;
+    w->size = st.st_size;
+    w->rounds = (const wave_round *) (w->header + 1);
+    w->paths = (const wave_path *) (w->rounds + w->header->rounds);
+
+    if (memcmp(w->header->magic, WAVE_MAGIC, 4)) {
+
+        wave_close(w);
+        return bad("not a wave file");
+    }
+
+    if (check(w)) {
+
+        wave_close(w);
+        return -1;
+    }
+
+    return 0;
+}
+
+void wave_close(wave_file *w) {
+
+    if (w->header) munmap((void *) w->header, w->size);
+
+    w->header = NULL;
+}
+
+wave_formation wave_formation_of(const wave_file *w, int r) {
+
+    const wave_round *round = &w->rounds[r];
+    const uint8_t *base = (const uint8_t *) w->header + round->formation;
+    int n = round->enemies;
+
+    return (wave_formation) {
+        .count = n,
+        .x = (const int16_t *) base,
+        .y = (const int16_t *) base + n,
+        .sprite = base + 4 * n,
+        .row = base + 5 * n,
+        .col = base + 6 * n,
+        .path = base + 7 * n,
+    };
+}
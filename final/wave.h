@@ -0,0 +1,110 @@
+#ifndef _WAVE_H
+#define _WAVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Round layouts and dive paths, compiled by wavec from a text source
+ * (see waves.txt) into one binary file that is mmap'd and read in
+ * place.  Nothing is parsed at load time: wave_open() checks the
+ * header and that every offset lands inside the file, and from then
+ * on the tables are used straight from the mapping.
+ *
+ *     wave_header
+ *     wave_round[rounds]          where each formation is
+ *     wave_path[paths]            where each path's samples are
+ *     formations, paths' samples  4-byte aligned
+ *
+ * A formation is stored the way enemy_store keeps it, one array per
+ * field in enemy order, so laying out a round is a memcpy per field.
+ *
+ * A dive path is baked by wavec, from steps or from a Catmull-Rom or
+ * Bezier spline, into a table of Q8.8 velocities sampled every
+ * 1 << shift ticks.  An enemy on it takes the velocity for its tick by
+ * lerping between the two samples around it (wave_path_velocity()),
+ * so every enemy flying a path shares the one table and the per-tick
+ * cost is a couple of loads and a multiply.
+ *
+ * Offsets are from the start of the file.  Everything is little
+ * endian, which both the board and the hosts are.
+ */
+
+#define WAVE_MAGIC "WAVE"
+#define WAVE_VERSION 3
+
+/* Largest formation grid the game has room for; a row of cells must
+   fit the 32-bit masks wave_open() checks them with */
+#define MAX_ROWS 8
+#define MAX_COLUMNS 32
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t columns, rows;     /* the grid every round sits in */
+    uint16_t rounds, paths;
+    uint16_t pad;
+    uint32_t size;              /* of the whole file */
+} wave_header;
+
+typedef struct {
+    uint16_t enemies;
+    uint16_t every;             /* ticks between dives, past the opening rushes */
+    uint32_t formation;         /* offset of its wave_formation arrays */
+} wave_round;
+
+/* A dive path, velocities sampled every 1 << shift ticks */
+typedef struct {
+    uint16_t length;            /* in ticks */
+    uint16_t samples;           /* ((length - 1) >> shift) + 2 */
+    uint8_t shift;
+    uint8_t pad[3];
+    uint32_t velocity;          /* offset of int16_t vx[samples], vy[samples] */
+} wave_path;
+
+/* Sampled velocities of a path of length ticks, so the lerp at every
+   tick has a sample on either side */
+#define WAVE_SAMPLES(length, shift) ((((length) - 1) >> (shift)) + 2)
+
+/* An opened file */
+typedef struct {
+    const wave_header *header;
+    const wave_round *rounds;
+    const wave_path *paths;
+    size_t size;
+} wave_file;
+
+/* Round r's formation, pointing into the file */
+typedef struct {
+    int count;
+    const int16_t *x, *y;       /* its place in formation, in pixels */
+    const uint8_t *sprite;
+    const uint8_t *row, *col;
+    const uint8_t *path;        /* which dive path it flies */
+} wave_formation;
+
+/* Map and check the file at path.  Returns 0, or -1 with a message
+   on stderr. */
+extern int wave_open(wave_file *, const char *path);
+
+extern void wave_close(wave_file *);
+
+/* Formation of round r, counting from 0 */
+extern wave_formation wave_formation_of(const wave_file *, int r);
+
+/* Velocity in Q8.8 pixels per tick at tick t (0 .. length-1) of
+   path p, with +x away from the middle of the screen */
+static inline void wave_path_velocity(const wave_file *w, int p, int t, short *vx, short *vy) {
+
+    const wave_path *path = &w->paths[p];
+    const int16_t *v = (const int16_t *) ((const uint8_t *) w->header + path->velocity);
+    int k = t >> path->shift, f = t & ((1 << path->shift) - 1), n = path->samples;
+
+    *vx = v[k] + ((v[k + 1] - v[k]) * f >> path->shift);
+    *vy = v[n + k] + ((v[n + k + 1] - v[n + k]) * f >> path->shift);
+}
+
+/* Bytes a formation of n enemies takes in the file, before padding */
+#define WAVE_FORMATION_SIZE(n) ((n) * (2 * sizeof(int16_t) + 4))
+
+#endif
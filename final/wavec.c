@@ -0,0 +1,427 @@
+/*
+ * wavec: compile a wave source (see waves.txt) into the binary file
+ * the game maps at startup (see wave.h).
+ *
+ *     wavec waves.txt waves.bin
+ *
+ * Runs on the build host.  The limits checked here are the ones the
+ * game was compiled with, so a file wavec accepts is one wave_open()
+ * accepts.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "wave.h"
+#include "vga_ball.h"
+
+#define MAX_ROUNDS 64
+#define MAX_PATHS 256
+#define MAX_STEPS 1024
+#define MAX_POINTS 64
+#define NAME_LEN 32
+
+/* Splines are sampled every 1 << SPLINE_SHIFT ticks */
+#define SPLINE_SHIFT 2
+
+enum { STEPS, CATMULL, BEZIER };
+
+typedef struct {
+    char name[NAME_LEN];
+    int kind, length;
+    int8_t dx[MAX_STEPS], dy[MAX_STEPS];        /* STEPS */
+    double x[MAX_POINTS], y[MAX_POINTS];        /* splines' control points */
+    int points;
+
+    /* Baked */
+    int shift, samples;
+    int16_t vx[MAX_STEPS + 2], vy[MAX_STEPS + 2];
+} path_source;
+
+typedef struct {
+    int count;
+    int16_t x[ENEMY_COUNT], y[ENEMY_COUNT];
+    uint8_t sprite[ENEMY_COUNT], row[ENEMY_COUNT], col[ENEMY_COUNT], path[ENEMY_COUNT];
+    uint32_t taken[MAX_ROWS];   /* a bit per column */
+    int rows, every;
+} round_source;
+
+static path_source paths[MAX_PATHS];
+static round_source rounds[MAX_ROUNDS];
+static int path_count, round_count, columns;
+
+/* Pixel place of row 0, column 0 and the spacing of the grid */
+static int grid_x = 50, grid_y = 90, grid_dx = 26, grid_dy = 30;
+
+static const char *source;
+static int line_no;
+
+static void fail(const char *why) {
+
+    fprintf(stderr, "%s:%d: %s\n", source, line_no, why);
+    exit(EXIT_FAILURE);
+}
+
+static int find_path(const char *name) {
+
+    for (int p = 0; p < path_count; p++)
+        if (!strcmp(paths[p].name, name)) return p;
+
+    fail("no such path");
+    return -1;
+}
+
+/* x y: a spline's next control point */
+static void add_point(path_source *p, const char *line) {
+
+    if (p->points == MAX_POINTS) fail("too many control points");
+
+    if (sscanf(line, "%lf %lf", &p->x[p->points], &p->y[p->points]) != 2)
+        fail("expected: x y");
+
+    p->points++;
+}
+
+/* dx dy [ticks] */
+static void add_steps(path_source *p, const char *line) {
+
+    int dx, dy, ticks = 1, got = sscanf(line, "%d %d %d", &dx, &dy, &ticks);
+
+    if (got < 2 || ticks < 1) fail("expected: dx dy [ticks]");
+    if (dx < -128 || dx > 127 || dy < -128 || dy > 127) fail("step too large");
+    if (p->length + ticks > MAX_STEPS) fail("path too long");
+
+    while (ticks--) {
+        p->dx[p->length] = dx;
+        p->dy[p->length] = dy;
+        p->length++;
+    }
+}
+
+/* path layout: one character per column */
+static void add_row(round_source *r, const char *line) {
+
+    char name[NAME_LEN], layout[MAX_COLUMNS + 2];
+    int path;
+
+    if (sscanf(line, "%31s %33s", name, layout) != 2) fail("expected: path layout");
+
+    path = find_path(name);
+
+    if (strlen(layout) > MAX_COLUMNS) fail("row wider than MAX_COLUMNS");
+    if (!columns) columns = strlen(layout);
+    if ((int) strlen(layout) != columns) fail("rows differ in width");
+    if (r->rows == MAX_ROWS) fail("more rows than MAX_ROWS");
+
+    for (int c = 0; c < columns; c++) {
+
+        int sprite = 0, i = r->count;
+
+        switch (layout[c]) {
+            case '.': continue;
+            case '1': sprite = ENEMY1; break;
+            case '2': sprite = ENEMY2; break;
+            case '3': sprite = ENEMY3; break;
+            default: fail("layout characters are . 1 2 3");
+        }
+
+        if (i == ENEMY_COUNT) fail("more enemies than ENEMY_COUNT");
+        if (r->taken[r->rows] >> c & 1) fail("two enemies in one cell");
+
+        r->taken[r->rows] |= 1u << c;
+
+        r->x[i] = grid_x + c * grid_dx;
+        r->y[i] = grid_y + r->rows * grid_dy;
+        r->sprite[i] = sprite;
+        r->row[i] = r->rows;
+        r->col[i] = c;
+        r->path[i] = path;
+        r->count++;
+    }
+
+    r->rows++;
+}
+
+static void parse(FILE *in) {
+
+    char line[256], word[NAME_LEN], kind[16], *hash;
+    path_source *p = NULL;
+    round_source *r = NULL;
+
+    while (fgets(line, sizeof(line), in)) {
+
+        line_no++;
+
+        if ((hash = strchr(line, '#'))) *hash = 0;
+        if (sscanf(line, "%31s", word) != 1) continue;
+
+        if (!strcmp(word, "grid")) {
+
+            if (sscanf(line, "%*s %d %d %d %d", &grid_x, &grid_y, &grid_dx, &grid_dy) != 4)
+                fail("expected: grid x y dx dy");
+        }
+
+        else if (!strcmp(word, "path")) {
+
+            if (path_count == MAX_PATHS) fail("too many paths");
+
+            p = &paths[path_count++];
+            r = NULL;
+
+            kind[0] = 0;
+
+            if (sscanf(line, "%*s %31s %15s %d", p->name, kind, &p->length) < 1)
+                fail("expected: path name [catmull|bezier ticks]");
+
+            p->kind = !strcmp(kind, "catmull") ? CATMULL : !strcmp(kind, "bezier") ? BEZIER : STEPS;
+
+            if (p->kind != STEPS && (p->length < 1 || p->length > MAX_STEPS))
+                fail("a spline needs its length in ticks");
+        }
+
+        else if (!strcmp(word, "round")) {
+
+            if (round_count == MAX_ROUNDS) fail("too many rounds");
+
+            r = &rounds[round_count++];
+            p = NULL;
+
+            if (sscanf(line, "%*s %d", &r->every) != 1 || r->every < 1 || r->every > UINT16_MAX)
+                fail("expected: round every");
+        }
+
+        else if (p && p->kind == STEPS) add_steps(p, line);
+
+        else if (p) add_point(p, line);
+
+        else if (r) add_row(r, line);
+
+        else fail("expected grid, path or round");
+    }
+
+    if (!round_count || !path_count) fail("need at least one path and one round");
+
+    for (int k = 0; k < path_count; k++) {
+
+        path_source *q = &paths[k];
+
+        if (q->kind == CATMULL && q->points < 2) fail("a Catmull-Rom path needs 2 points or more");
+        if (q->kind == BEZIER && (q->points < 4 || q->points % 3 != 1))
+            fail("a Bezier path needs 3n+1 points");
+        if (!q->length) fail("empty path");
+    }
+}
+
+/* Point u (0 .. 1) along segment s of p's spline */
+static void spline_at(const path_source *p, int s, double u, double *x, double *y) {
+
+    double w[4];
+    const double *px = p->x, *py = p->y;
+    int at[4];
+
+    if (p->kind == CATMULL) {
+
+        /* Through every point; the ends repeat to give the first and
+           last segments their neighbours */
+        for (int j = 0; j < 4; j++) {
+            at[j] = s - 1 + j;
+            if (at[j] < 0) at[j] = 0;
+            if (at[j] >= p->points) at[j] = p->points - 1;
+        }
+
+        w[0] = ((-u + 2) * u - 1) * u / 2;
+        w[1] = ((3 * u - 5) * u * u + 2) / 2;
+        w[2] = ((-3 * u + 4) * u + 1) * u / 2;
+        w[3] = (u - 1) * u * u / 2;
+    }
+    else {
+
+        for (int j = 0; j < 4; j++) at[j] = 3 * s + j;
+
+        w[0] = (1 - u) * (1 - u) * (1 - u);
+        w[1] = 3 * u * (1 - u) * (1 - u);
+        w[2] = 3 * u * u * (1 - u);
+        w[3] = u * u * u;
+    }
+
+    *x = *y = 0;
+
+    for (int j = 0; j < 4; j++) {
+        *x += w[j] * px[at[j]];
+        *y += w[j] * py[at[j]];
+    }
+}
+
+/* Where p's spline is t ticks in, spreading its length evenly over
+   the segments */
+static void spline_tick(const path_source *p, double t, double *x, double *y) {
+
+    int segments = p->kind == CATMULL ? p->points - 1 : (p->points - 1) / 3;
+    double u = t < 0 ? 0 : t > p->length ? segments : t * segments / p->length;
+    int s = u >= segments ? segments - 1 : (int) u;
+
+    spline_at(p, s, u - s, x, y);
+}
+
+static int16_t q8_8(double v) {
+
+    v = round(v * 256);
+
+    if (v < INT16_MIN || v > INT16_MAX) fail("path too fast");
+
+    return v;
+}
+
+/*
+ * Bake p into Q8.8 velocities.  Steps are exact, one sample a tick.
+ * A spline gets a sample every 1 << SPLINE_SHIFT ticks, each the
+ * average velocity over the tick centred on it; the game lerps in
+ * between.
+ */
+static void bake(path_source *p) {
+
+    double x0, y0, x1, y1;
+    int t;
+
+    p->shift = p->kind == STEPS ? 0 : SPLINE_SHIFT;
+    p->samples = WAVE_SAMPLES(p->length, p->shift);
+
+    for (int k = 0; k < p->samples; k++) {
+
+        t = k << p->shift;
+
+        if (p->kind == STEPS) {
+
+            if (t >= p->length) t = p->length - 1;
+
+            p->vx[k] = q8_8(p->dx[t]);
+            p->vy[k] = q8_8(p->dy[t]);
+            continue;
+        }
+
+        spline_tick(p, t - 0.5, &x0, &y0);
+        spline_tick(p, t + 0.5, &x1, &y1);
+
+        p->vx[k] = q8_8(x1 - x0);
+        p->vy[k] = q8_8(y1 - y0);
+    }
+}
+
+static size_t align4(size_t n) {
+
+    return (n + 3) & ~(size_t) 3;
+}
+
+/* Lay the file out in one buffer; see wave.h */
+static uint8_t *build(size_t *size) {
+
+    size_t at = sizeof(wave_header) + round_count * sizeof(wave_round) + path_count * sizeof(wave_path);
+    wave_header *h;
+    wave_round *wr;
+    wave_path *wp;
+    uint8_t *out;
+    int rows = 0;
+
+    for (int k = 0; k < round_count; k++) {
+        at = align4(at + WAVE_FORMATION_SIZE(rounds[k].count));
+        if (rounds[k].rows > rows) rows = rounds[k].rows;
+    }
+
+    for (int k = 0; k < path_count; k++) {
+        bake(&paths[k]);
+        at = align4(at + 2 * paths[k].samples * sizeof(int16_t));
+    }
+
+    if (at > UINT32_MAX) fail("file too large");
+
+    out = calloc(1, at);
+    h = (wave_header *) out;
+    wr = (wave_round *) (h + 1);
+    wp = (wave_path *) (wr + round_count);
+
+    memcpy(h->magic, WAVE_MAGIC, 4);
+    h->version = WAVE_VERSION;
+    h->columns = columns;
+    h->rows = rows;
+    h->rounds = round_count;
+    h->paths = path_count;
+    h->size = at;
+
+    at = (uint8_t *) (wp + path_count) - out;
+
+    for (int k = 0; k < round_count; k++) {
+
+        round_source *r = &rounds[k];
+        uint8_t *f = out + at;
+        int n = r->count;
+
+        wr[k].enemies = n;
+        wr[k].every = r->every;
+        wr[k].formation = at;
+
+        memcpy(f, r->x, n * sizeof(int16_t));
+        memcpy(f + 2 * n, r->y, n * sizeof(int16_t));
+        memcpy(f + 4 * n, r->sprite, n);
+        memcpy(f + 5 * n, r->row, n);
+        memcpy(f + 6 * n, r->col, n);
+        memcpy(f + 7 * n, r->path, n);
+
+        at = align4(at + WAVE_FORMATION_SIZE(n));
+    }
+
+    for (int k = 0; k < path_count; k++) {
+
+        int n = paths[k].samples;
+
+        wp[k].length = paths[k].length;
+        wp[k].samples = n;
+        wp[k].shift = paths[k].shift;
+        wp[k].velocity = at;
+
+        memcpy(out + at, paths[k].vx, n * sizeof(int16_t));
+        memcpy(out + at + n * sizeof(int16_t), paths[k].vy, n * sizeof(int16_t));
+
+        at = align4(at + 2 * n * sizeof(int16_t));
+    }
+
+    *size = at;
+
+    return out;
+}
+
+
+int main(int argc, char *argv[]) {
+
+    FILE *in, *out;
+    uint8_t *file;
+    size_t size;
+
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s source.txt waves.bin\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    source = argv[1];
+
+    if (!(in = fopen(source, "r"))) {
+        perror(source);
+        return EXIT_FAILURE;
+    }
+
+    parse(in);
+    fclose(in);
+
+    file = build(&size);
+
+    if (!(out = fopen(argv[2], "wb")) || fwrite(file, 1, size, out) != size || fclose(out)) {
+        perror(argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    printf("%s: %d rounds, %d paths, %zu bytes\n", argv[2], round_count, path_count, size);
+
+    free(file);
+
+    return 0;
+}
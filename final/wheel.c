@@ -0,0 +1,120 @@
+#include "wheel.h"
+
+#define SLOT(t, level) (((t) >> ((level) * WHEEL_BITS)) & (WHEEL_SLOTS - 1))
+
+void wheel_init(timer_wheel *w, int capacity){
+
+    w->now = 0;
+    pool_init(&w->timers, capacity);
+
+    for (int l = 0; l < WHEEL_LEVELS; l++)
+        for (int s = 0; s < WHEEL_SLOTS; s++)
+            w->head[l][s] = -1;
+}
+
+/* Head of the list timer t is on */
+static short *head_of(timer_wheel *w, int t){
+
+    return &w->head[w->level[t]][SLOT(w->expires[t], w->level[t])];
+}
+
+/* Put timer t in the slot its distance from now calls for */
+static void attach(timer_wheel *w, int t){
+
+    unsigned int delta = w->expires[t] - w->now;
+    int level = 0;
+    short *head;
+
+    while (level < WHEEL_LEVELS - 1 && delta >> ((level + 1) * WHEEL_BITS))
+        level++;
+
+    w->level[t] = level;
+    head = head_of(w, t);
+
+    w->prev[t] = -1;
+    w->next[t] = *head;
+
+    if (*head != -1) w->prev[*head] = t;
+    *head = t;
+}
+
+static void detach(timer_wheel *w, int t, short *head){
+
+    if (w->prev[t] != -1) w->next[w->prev[t]] = w->next[t];
+    else *head = w->next[t];
+
+    if (w->next[t] != -1) w->prev[w->next[t]] = w->prev[t];
+}
+
+pool_handle wheel_add(timer_wheel *w, unsigned int delay, int event, int arg){
+
+    int t;
+
+    if ((t = pool_acquire(&w->timers)) == -1) return POOL_NONE;
+
+    if (delay < 1) delay = 1;
+    if (delay > WHEEL_MAX_DELAY) delay = WHEEL_MAX_DELAY;
+
+    w->expires[t] = w->now + delay;
+    w->event[t] = event;
+    w->arg[t] = arg;
+
+    attach(w, t);
+
+    return pool_handle_of(&w->timers, t);
+}
+
+void wheel_cancel(timer_wheel *w, pool_handle h){
+
+    int t = pool_slot(&w->timers, h);
+
+    if (t == -1) return;
+
+    detach(w, t, head_of(w, t));
+    pool_release(&w->timers, t);
+}
+
+unsigned int wheel_remaining(const timer_wheel *w, pool_handle h){
+
+    int t = pool_slot(&w->timers, h);
+
+    return t == -1 ? 0 : w->expires[t] - w->now;
+}
+
+/* Move every timer in a coarser slot down to where it now belongs */
+static void cascade(timer_wheel *w, int level){
+
+    short *head = &w->head[level][SLOT(w->now, level)];
+    int t;
+
+    while ((t = *head) != -1){
+
+        detach(w, t, head);
+        attach(w, t);
+    }
+}
+
+void wheel_advance(timer_wheel *w, wheel_fire fire){
+
+    short *head;
+    int t;
+
+    w->now++;
+
+    /* Each wrap of a level empties the matching slot of the level above */
+    for (int l = 1; l < WHEEL_LEVELS; l++)
+        if (!(w->now & ((1u << (l * WHEEL_BITS)) - 1)))
+            cascade(w, l);
+
+    /* A callback may add or cancel timers, but anything it adds is at
+       least a tick out, so it never lands on this slot */
+    head = &w->head[0][SLOT(w->now, 0)];
+
+    while ((t = *head) != -1){
+
+        detach(w, t, head);
+        pool_release(&w->timers, t);
+
+        fire(w->event[t], w->arg[t]);
+    }
+}
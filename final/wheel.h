@@ -0,0 +1,56 @@
+#ifndef _WHEEL_H
+#define _WHEEL_H
+
+#include "pool.h"
+
+/* Slots per level and levels: timers up to 64^3 ticks out */
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_LEVELS 3
+#define WHEEL_MAX_DELAY ((1u << (WHEEL_BITS * WHEEL_LEVELS)) - 1)
+
+/*
+ * Hierarchical timer wheel over simulation ticks.
+ *
+ * Level 0 has one slot per tick for the next 64 ticks, level 1 one
+ * slot per 64 ticks, level 2 one per 4096.  A timer sits in the
+ * coarsest slot that still tells it apart from now and moves down a
+ * level when the wheel below wraps, so a tick only touches the timers
+ * that fire in it, plus a cascade every 64 ticks.
+ *
+ * Timers carry an event number and an argument rather than a function
+ * pointer, so the wheel is plain data: it hashes and copies like the
+ * rest of the game state.  Handles come from the wheel's pool and go
+ * stale once the timer fires or is cancelled.
+ */
+typedef struct {
+    unsigned int now;                   /* ticks advanced so far */
+    pool timers;
+    unsigned int expires[POOL_CAPACITY];
+    unsigned char event[POOL_CAPACITY], level[POOL_CAPACITY];
+    int arg[POOL_CAPACITY];
+    short next[POOL_CAPACITY], prev[POOL_CAPACITY];
+    short head[WHEEL_LEVELS][WHEEL_SLOTS];
+} timer_wheel;
+
+/* Called for each timer as it fires, after its handle has gone stale */
+typedef void (*wheel_fire)(int event, int arg);
+
+/* Empty the wheel, with room for capacity timers */
+extern void wheel_init(timer_wheel *, int capacity);
+
+/* Fire event with arg delay ticks from now (at least 1, at most
+   WHEEL_MAX_DELAY).  Returns the timer's handle, POOL_NONE if the
+   wheel is full. */
+extern pool_handle wheel_add(timer_wheel *, unsigned int delay, int event, int arg);
+
+/* Drop a pending timer.  Stale handles and POOL_NONE are ignored. */
+extern void wheel_cancel(timer_wheel *, pool_handle);
+
+/* Ticks until a pending timer fires, 0 if it is not pending */
+extern unsigned int wheel_remaining(const timer_wheel *, pool_handle);
+
+/* Move on one tick and fire every timer due in it */
+extern void wheel_advance(timer_wheel *, wheel_fire);
+
+#endif